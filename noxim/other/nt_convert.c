@@ -0,0 +1,163 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * nt_convert: converts a netrace .tra.bz2 trace into the native format
+ * read by netrace.c through mmap (see struct nt_native_header). The
+ * result is uncompressed, so it is several times larger than the input,
+ * but replaying it costs no decompression at all.
+ *
+ * usage: nt_convert input.tra.bz2 output.ntr
+ */
+
+#include "netrace.h"
+
+static void write_or_die( const void* ptr, size_t size, size_t count, FILE* fp )
+{
+	if( fwrite( ptr, size, count, fp ) != count ) {
+		nt_error( "failed to write output file" );
+	}
+}
+
+int main( int argc, char** argv )
+{
+	nt_native_header_t out_header;
+	unsigned long long int* cycles = NULL;
+	unsigned long long int max_buckets = 0;
+	unsigned int next_region = 0;
+	unsigned int i;
+
+	if( argc < 3 ) {
+		fprintf( stderr, "usage: %s input.tra.bz2 output.ntr\n", argv[0] );
+		return 1;
+	}
+
+	nt_open_trfile( argv[1] );
+	if( nt_input_map != NULL ) {
+		nt_error( "input is already a native trace file" );
+	}
+	nt_header_t* header = nt_get_trheader();
+	unsigned long long int header_size = nt_get_headersize();
+
+	FILE* out_fp = fopen( argv[2], "wb" );
+	FILE* deps_fp = tmpfile();
+	if( out_fp == NULL || deps_fp == NULL ) {
+		nt_error( "failed to open output file" );
+	}
+
+	memset( &out_header, 0, sizeof(out_header) );
+	out_header.magic = NT_NATIVE_MAGIC;
+	out_header.version = NT_NATIVE_VERSION;
+	out_header.cycle_step = NT_NATIVE_CYCLE_STEP;
+	out_header.num_regions = header->num_regions;
+	out_header.trheader_offset = sizeof(nt_native_header_t);
+	out_header.trheader_length = header_size;
+	// Keep the packet table 8-byte aligned for the mapped reader
+	out_header.packets_offset = ( out_header.trheader_offset + header_size + 7 ) & ~7ULL;
+
+	// Copy the original header verbatim
+	char* trheader = (char*) nt_checked_malloc( header_size );
+	nt_trfile_seek( 0 );
+	if( nt_trfile_read( trheader, header_size ) < header_size ) {
+		nt_error( "failed to read trace file header" );
+	}
+	write_or_die( &out_header, sizeof(out_header), 1, out_fp );
+	write_or_die( trheader, 1, header_size, out_fp );
+	free( trheader );
+	fseeko( out_fp, (off_t) out_header.packets_offset, SEEK_SET );
+
+	nt_native_region_t* regions = NULL;
+	if( header->num_regions > 0 ) {
+		regions = (nt_native_region_t*) nt_checked_malloc( header->num_regions * sizeof(nt_native_region_t) );
+	}
+
+	for( ;; ) {
+		// A region starts at the first packet at or past its seek offset
+		unsigned long long int offset = nt_input_offset - header_size;
+		while( next_region < header->num_regions && header->regions[next_region].seek_offset <= offset ) {
+			regions[next_region].seek_offset = header->regions[next_region].seek_offset;
+			regions[next_region].first_packet = out_header.num_packets;
+			next_region++;
+		}
+		nt_packet_t* packet = nt_decode_packet();
+		if( packet == NULL ) {
+			break;
+		}
+		nt_native_packet_t record;
+		memset( &record, 0, sizeof(record) );
+		record.cycle = packet->cycle;
+		record.id = packet->id;
+		record.addr = packet->addr;
+		record.dep_offset = out_header.num_deps;
+		record.type = packet->type;
+		record.src = packet->src;
+		record.dst = packet->dst;
+		record.node_types = packet->node_types;
+		record.num_deps = packet->num_deps;
+		write_or_die( &record, sizeof(record), 1, out_fp );
+		if( packet->num_deps > 0 ) {
+			write_or_die( packet->deps, sizeof(nt_dependency_t), packet->num_deps, deps_fp );
+			out_header.num_deps += packet->num_deps;
+		}
+
+		// Cycle index: first packet at or after each cycle_step boundary
+		unsigned long long int bucket = packet->cycle / NT_NATIVE_CYCLE_STEP;
+		if( bucket + 1 > max_buckets ) {
+			unsigned long long int new_max = max_buckets ? max_buckets : 1024;
+			while( new_max < bucket + 1 ) {
+				new_max *= 2;
+			}
+			cycles = realloc( cycles, new_max * sizeof(unsigned long long int) );
+			if( cycles == NULL ) {
+				nt_error( "out of memory" );
+			}
+			max_buckets = new_max;
+		}
+		while( out_header.num_cycle_buckets <= bucket ) {
+			cycles[out_header.num_cycle_buckets++] = out_header.num_packets;
+		}
+
+		out_header.num_packets++;
+		nt_packet_free( packet );
+	}
+	// Regions past the last packet are empty
+	for( ; next_region < header->num_regions; next_region++ ) {
+		regions[next_region].seek_offset = header->regions[next_region].seek_offset;
+		regions[next_region].first_packet = out_header.num_packets;
+	}
+
+	// Dependencies, then region and cycle tables
+	out_header.deps_offset = out_header.packets_offset + out_header.num_packets * sizeof(nt_native_packet_t);
+	char buffer[65536];
+	size_t n;
+	rewind( deps_fp );
+	while( ( n = fread( buffer, 1, sizeof(buffer), deps_fp ) ) > 0 ) {
+		write_or_die( buffer, 1, n, out_fp );
+	}
+	fclose( deps_fp );
+	out_header.regions_offset = ( out_header.deps_offset + out_header.num_deps * sizeof(nt_dependency_t) + 7 ) & ~7ULL;
+	fseeko( out_fp, (off_t) out_header.regions_offset, SEEK_SET );
+	if( header->num_regions > 0 ) {
+		write_or_die( regions, sizeof(nt_native_region_t), header->num_regions, out_fp );
+	}
+	out_header.cycles_offset = out_header.regions_offset + header->num_regions * sizeof(nt_native_region_t);
+	if( out_header.num_cycle_buckets > 0 ) {
+		write_or_die( cycles, sizeof(unsigned long long int), out_header.num_cycle_buckets, out_fp );
+	}
+	rewind( out_fp );
+	write_or_die( &out_header, sizeof(out_header), 1, out_fp );
+	fclose( out_fp );
+	nt_close_trfile();
+
+	printf( "%s: %llu packets, %llu dependencies, %u regions\n", argv[2],
+			out_header.num_packets, out_header.num_deps, out_header.num_regions );
+	for( i = 0; i < out_header.num_regions; i++ ) {
+		printf( "  region %u: first packet %llu\n", i, regions[i].first_packet );
+	}
+	free( regions );
+	free( cycles );
+	return 0;
+}
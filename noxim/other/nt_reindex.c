@@ -0,0 +1,158 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * nt_reindex: recompresses a netrace trace as a series of concatenated
+ * bzip2 streams and writes a sidecar index (<output>.idx) mapping each
+ * stream to the trace offset it starts at. The output is still a valid
+ * .tra.bz2 file; with the index next to it nt_seek_region() jumps to the
+ * closest stream instead of decompressing the whole prefix.
+ *
+ * usage: nt_reindex input.tra.bz2 output.tra.bz2 [chunk_MB]
+ */
+
+#include "netrace.h"
+
+#define DEFAULT_CHUNK_MB	16
+
+static FILE*		out_fp;
+static BZFILE*		out_bz;
+static nt_index_entry_t* entries;
+static unsigned int	num_entries;
+static unsigned int	max_entries;
+
+static void start_stream( unsigned long long int raw_offset )
+{
+	int bzerr;
+	if( out_bz != NULL ) {
+		BZ2_bzWriteClose( &bzerr, out_bz, 0, NULL, NULL );
+		if( bzerr != BZ_OK ) {
+			nt_error( "failed to close bzip2 stream" );
+		}
+	}
+	if( num_entries == max_entries ) {
+		max_entries = max_entries ? 2 * max_entries : 64;
+		entries = realloc( entries, max_entries * sizeof(nt_index_entry_t) );
+		if( entries == NULL ) {
+			nt_error( "out of memory" );
+		}
+	}
+	entries[num_entries].raw_offset = raw_offset;
+	entries[num_entries].file_offset = (unsigned long long int) ftello( out_fp );
+	num_entries++;
+	out_bz = BZ2_bzWriteOpen( &bzerr, out_fp, 9, 0, 0 );
+	if( bzerr != BZ_OK ) {
+		nt_error( "failed to open bzip2 stream" );
+	}
+}
+
+int main( int argc, char** argv )
+{
+	unsigned long long int chunk = DEFAULT_CHUNK_MB;
+	unsigned long long int offset = 0;
+	unsigned long long int next_cut;
+	unsigned int next_region = 0;
+	unsigned int i;
+	int bzerr;
+
+	if( argc < 3 ) {
+		fprintf( stderr, "usage: %s input.tra.bz2 output.tra.bz2 [chunk_MB]\n", argv[0] );
+		return 1;
+	}
+	if( argc > 3 ) {
+		chunk = strtoull( argv[3], NULL, 10 );
+	}
+	chunk <<= 20;
+	if( chunk == 0 ) {
+		nt_error( "chunk size must be greater than zero" );
+	}
+
+	nt_open_trfile( argv[1] );
+	nt_header_t* header = nt_get_trheader();
+	unsigned long long int header_size = nt_get_headersize();
+	nt_trfile_seek( 0 );
+
+	out_fp = fopen( argv[2], "wb" );
+	if( out_fp == NULL ) {
+		nt_error( "failed to open output file" );
+	}
+
+	// Every region start gets its own stream so a region seek never has
+	// to decompress anything before it
+	start_stream( 0 );
+	next_cut = chunk;
+	unsigned int buffer_size = 65536;
+	char* buffer = (char*) nt_checked_malloc( buffer_size );
+	for( ;; ) {
+		unsigned long long int limit = next_cut;
+		while( next_region < header->num_regions &&
+				header_size + header->regions[next_region].seek_offset <= offset ) {
+			next_region++;
+		}
+		if( next_region < header->num_regions &&
+				header_size + header->regions[next_region].seek_offset < limit ) {
+			limit = header_size + header->regions[next_region].seek_offset;
+		}
+		unsigned int want = ( limit - offset > buffer_size ) ? buffer_size : (unsigned int) ( limit - offset );
+		int got = nt_trfile_read( buffer, want );
+		if( got > 0 ) {
+			BZ2_bzWrite( &bzerr, out_bz, buffer, got );
+			if( bzerr != BZ_OK ) {
+				nt_error( "failed to compress trace data" );
+			}
+			offset += got;
+		}
+		if( got < want ) {
+			break;
+		}
+		if( offset == limit ) {
+			start_stream( offset );
+			if( offset == next_cut ) {
+				next_cut += chunk;
+			}
+		}
+	}
+	free( buffer );
+	BZ2_bzWriteClose( &bzerr, out_bz, 0, NULL, NULL );
+	if( bzerr != BZ_OK ) {
+		nt_error( "failed to close bzip2 stream" );
+	}
+	// A cut that landed exactly on the end of the trace opened an empty stream
+	if( num_entries > 1 && entries[num_entries - 1].raw_offset == offset ) {
+		num_entries--;
+	}
+	fclose( out_fp );
+	nt_close_trfile();
+
+	char* idxname = (char*) nt_checked_malloc( strlen( argv[2] ) + strlen( NT_INDEX_SUFFIX ) + 1 );
+	sprintf( idxname, "%s%s", argv[2], NT_INDEX_SUFFIX );
+	FILE* idx_fp = fopen( idxname, "wb" );
+	if( idx_fp == NULL ) {
+		nt_error( "failed to open index file" );
+	}
+	struct stat st;
+	if( stat( argv[2], &st ) != 0 ) {
+		nt_error( "failed to stat output trace" );
+	}
+	nt_index_header_t idx_header;
+	memset( &idx_header, 0, sizeof(nt_index_header_t) );
+	idx_header.magic = NT_INDEX_MAGIC;
+	idx_header.version = NT_INDEX_VERSION;
+	idx_header.count = num_entries;
+	idx_header.source_size = (unsigned long long int) st.st_size;
+	idx_header.source_mtime = (long long int) st.st_mtime;
+	fwrite( &idx_header, sizeof(nt_index_header_t), 1, idx_fp );
+	fwrite( entries, sizeof(nt_index_entry_t), num_entries, idx_fp );
+	fclose( idx_fp );
+
+	printf( "%s: %llu bytes in %u streams, index written to %s\n", argv[2], offset, num_entries, idxname );
+	for( i = 0; i < num_entries; i++ ) {
+		printf( "  stream %u: trace offset %llu, file offset %llu\n", i, entries[i].raw_offset, entries[i].file_offset );
+	}
+	free( idxname );
+	free( entries );
+	return 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the declaration of the barrier between the threads of
+ * the flat engine
+ */
+
+#ifndef __NOXIMBARRIER_H__
+#define __NOXIMBARRIER_H__
+
+#include <atomic>
+#include <sched.h>
+
+using namespace std;
+
+// Waits for a fixed number of threads. The flat engine passes a few of them
+// every cycle, too often to put threads to sleep: waiting threads yield the
+// core instead, so the barrier stays usable with more threads than cores.
+class Barrier {
+
+  public:
+
+    Barrier() : parties(1), arrived(0), phase(0) {}
+
+    // Before any thread waits
+    void setParties(const int _parties) {
+	parties = _parties;
+    }
+
+    // Writes made by any thread before it waits are seen by all of them
+    // once they are through
+    void wait() {
+	const unsigned int current = phase.load(memory_order_acquire);
+
+	if (arrived.fetch_add(1, memory_order_acq_rel) == parties - 1) {
+	    arrived.store(0, memory_order_relaxed);
+	    phase.store(current + 1, memory_order_release);
+	} else
+	    while (phase.load(memory_order_acquire) == current)
+		sched_yield();
+    }
+
+  private:
+
+    int parties;
+    atomic<int> arrived;
+    atomic<unsigned int> phase;
+};
+
+#endif
@@ -10,22 +10,30 @@
 
 #include "Buffer.h"
 #include "Utils.h"
+#include "Checkpoint.h"
 
 Buffer::Buffer()
 {
+  ring = inline_ring;
+  head = 0;
+  count = 0;
   SetMaxBufferSize(GlobalParams::buffer_depth);
   max_occupancy = 0;
-  hold_time = 0.0;
-  last_event = 0.0;
-  hold_time_sum = 0.0;
-  previous_occupancy = 0;
-  mean_occupancy = 0.0;
+  last_event = 0;
+  occupancy_cycles = 0;
+  occupancy_sum = 0;
   true_buffer = true;
   full_cycles_counter = 0;
   last_front_flit_seq = NOT_VALID;
   deadlock_detected = false;
 }
 
+Buffer::~Buffer()
+{
+  if (ring != inline_ring)
+    delete[] ring;
+}
+
 
 void Buffer::setLabel(string l)
 {
@@ -38,21 +46,35 @@ string Buffer::getLabel() const
     return label;
 }
 
-void Buffer::Print()
+void Buffer::checkpoint(Checkpoint & cp)
 {
-    queue<Flit> m = buffer;
+    // flits are stored from the front, so a restored ring starts at slot 0
+    cp.transfer(count);
+    if (!cp.isSaving())
+	head = 0;
+    for (unsigned int i = 0; i < count; i++)
+	cp.transfer(ring[(head + i) & mask]);
+    cp.transfer(deadlock_detected);
+    cp.transfer(full_cycles_counter);
+    cp.transfer(last_front_flit_seq);
+    cp.transfer(max_occupancy);
+    cp.transfer(last_event);
+    cp.transfer(occupancy_cycles);
+    cp.transfer(occupancy_sum);
+}
 
+void Buffer::Print()
+{
     string bstr = "";
    
 
     char  t[] = "HBT";
 
-    cout << sc_time_stamp().to_double() / GlobalParams::clock_period_ps << "\t";
+    cout << currentCycle() << "\t";
     cout << label << " | ";
-    while (!(m.empty()))
+    for (unsigned int i = 0; i < count; i++)
     {
-	Flit f = m.front();
-	m.pop();
+	const Flit & f = FlitPool::get(ring[(head + i) & mask]);
 	cout << bstr << t[f.flit_type] << f.sequence_no <<  "(" << f.dst_id << ") | ";
     }
     cout << endl;
@@ -66,7 +88,7 @@ void Buffer::deadlockCheck()
 
     if (IsEmpty()) return;
 
-    Flit f = buffer.front();
+    const Flit & f = FlitPool::get(ring[head]);
     int seq = f.sequence_no;
 
     if (last_front_flit_seq==seq)
@@ -86,7 +108,7 @@ void Buffer::deadlockCheck()
 
     if (full_cycles_counter>check_threshold && !deadlock_detected) 
     {
-	double current_time = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+	double current_time = currentCycle();
 	cout << "WARNING: DEADLOCK DETECTED at cycle " << current_time << " in buffer:  " << getLabel() << endl;
 	deadlock_detected = true;
     }
@@ -97,7 +119,7 @@ bool Buffer::deadlockFree()
 {
     if (IsEmpty()) return true;
 
-    Flit f = buffer.front();
+    const Flit & f = FlitPool::get(ring[head]);
     
     int seq = f.sequence_no;
 
@@ -129,26 +151,21 @@ void Buffer::Disable()
 void Buffer::SetMaxBufferSize(const unsigned int bms)
 {
   assert(bms > 0);
+  assert(IsEmpty());
 
-  max_buffer_size = bms;
-}
-
-unsigned int Buffer::GetMaxBufferSize() const
-{
-  return max_buffer_size;
-}
-
-bool Buffer::IsFull() const
-{
-  return buffer.size() == max_buffer_size;
-}
+  unsigned int slots = 1;
+  while (slots < bms)
+    slots <<= 1;
 
-bool Buffer::IsEmpty() const
-{
-  return buffer.size() == 0;
+  if (ring != inline_ring)
+    delete[] ring;
+  ring = slots <= BUFFER_INLINE_SLOTS ? inline_ring : new FlitHandle[slots];
+  mask = slots - 1;
+  head = 0;
+  max_buffer_size = bms;
 }
 
-void Buffer::Drop(const Flit & flit) const
+void Buffer::Drop(const FlitHandle flit) const
 {
   assert(false);
 }
@@ -158,84 +175,56 @@ void Buffer::Empty() const
   assert(false);
 }
 
-void Buffer::Push(const Flit & flit)
+void Buffer::Push(const FlitHandle flit)
 {
-  SaveOccupancyAndTime();
-
-  if (IsFull())
+  if (IsFull()) {
     Drop(flit);
-  else
-    buffer.push(flit);
-  
-  UpdateMeanOccupancy();
-
-  if (max_occupancy < buffer.size())
-    max_occupancy = buffer.size();
-}
-
-Flit Buffer::Pop()
-{
-  Flit f;
-
-  SaveOccupancyAndTime();
-
-  if (IsEmpty())
-    Empty();
-  else {
-    f = buffer.front();
-    buffer.pop();
+    return;
   }
 
-  UpdateMeanOccupancy();
+  ring[(head + count) & mask] = flit;
+  count++;
+  UpdateOccupancy();
 
-  return f;
+  if (max_occupancy < count)
+    max_occupancy = count;
 }
 
-Flit Buffer::Front() const
+FlitHandle Buffer::Pop()
 {
-  Flit f;
-
-  if (IsEmpty())
+  if (IsEmpty()) {
     Empty();
-  else
-    f = buffer.front();
-
-  return f;
-}
+    return NO_FLIT;
+  }
 
-unsigned int Buffer::Size() const
-{
-  return buffer.size();
-}
+  FlitHandle f = ring[head];
+  head = (head + 1) & mask;
+  count--;
+  UpdateOccupancy();
 
-unsigned int Buffer::getCurrentFreeSlots() const
-{
-  return (GetMaxBufferSize() - Size());
+  return f;
 }
 
-void Buffer::SaveOccupancyAndTime()
+// Each event adds the occupancy it leaves times the cycles since the
+// previous one
+void Buffer::UpdateOccupancy()
 {
-  previous_occupancy = buffer.size();
-  hold_time = (sc_time_stamp().to_double() / GlobalParams::clock_period_ps) - last_event;
-  last_event = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
-}
+  long long now = currentCycle();
+  long long hold_time = now - last_event;
+  last_event = now;
 
-void Buffer::UpdateMeanOccupancy()
-{
-  double current_time = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
-  if (current_time - GlobalParams::reset_time < GlobalParams::stats_warm_up_time)
+  if (now - GlobalParams::reset_time < GlobalParams::stats_warm_up_time)
     return;
 
-  mean_occupancy = mean_occupancy * (hold_time_sum/(hold_time_sum+hold_time)) +
-    (1.0/(hold_time_sum+hold_time)) * hold_time * buffer.size();
-
-  hold_time_sum += hold_time;
+  occupancy_sum += hold_time * count;
+  occupancy_cycles += hold_time;
 }
 
 void Buffer::ShowStats(std::ostream & out)
 {
-  if (true_buffer)
+  if (true_buffer) {
+    double mean_occupancy = occupancy_cycles > 0 ? (double) occupancy_sum / occupancy_cycles : 0.0;
     out << "\t" << mean_occupancy << "\t" << max_occupancy;
-  else
+  } else
     out << "\t\t";
 }
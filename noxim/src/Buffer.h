@@ -12,38 +12,60 @@
 #define __NOXIMBUFFER_H__
 
 #include <cassert>
-#include <queue>
 #include "DataStructs.h"
+#include "FlitPool.h"
 using namespace std;
 
+class Checkpoint;
+
+// Buffers up to this depth keep their flits inside the Buffer itself
+#define BUFFER_INLINE_SLOTS	8
+
 class Buffer {
 
   public:
 
     Buffer();
 
-    virtual ~ Buffer() {
-    } void SetMaxBufferSize(const unsigned int bms);	// Set buffer max size (in flits)
+    virtual ~ Buffer();
 
-    unsigned int GetMaxBufferSize() const;	// Get max buffer size
+    void SetMaxBufferSize(const unsigned int bms);	// Set buffer max size (in flits), only while empty
 
-    unsigned int getCurrentFreeSlots() const;	// free buffer slots
+    unsigned int GetMaxBufferSize() const {	// Get max buffer size
+	return max_buffer_size;
+    }
 
-    bool IsFull() const;	// Returns true if buffer is full
+    unsigned int getCurrentFreeSlots() const {	// free buffer slots
+	return max_buffer_size - count;
+    }
 
-    bool IsEmpty() const;	// Returns true if buffer is empty
+    bool IsFull() const {	// Returns true if buffer is full
+	return count == max_buffer_size;
+    }
 
-    virtual void Drop(const Flit & flit) const;	// Called by Push() when buffer is full
+    bool IsEmpty() const {	// Returns true if buffer is empty
+	return count == 0;
+    }
+
+    virtual void Drop(const FlitHandle flit) const;	// Called by Push() when buffer is full
 
     virtual void Empty() const;	// Called by Pop() when buffer is empty
 
-    void Push(const Flit & flit);	// Push a flit. Calls Drop method if buffer is full
+    void Push(const FlitHandle flit);	// Push a flit. Calls Drop method if buffer is full
 
-    Flit Pop();		// Pop a flit
+    FlitHandle Pop();	// Pop a flit
 
-    Flit Front() const;	// Return a copy of the first flit in the buffer
+    FlitHandle Front() const {	// Return the first flit in the buffer
+	if (IsEmpty()) {
+	    Empty();
+	    return NO_FLIT;
+	}
+	return ring[head];
+    }
 
-    unsigned int Size() const;
+    unsigned int Size() const {
+	return count;
+    }
 
     void ShowStats(std::ostream & out);
 
@@ -59,8 +81,13 @@ class Buffer {
     void setLabel(string);
     string getLabel() const;
 
+    void checkpoint(Checkpoint & cp);	// Save or restore flits and statistics
+
   private:
 
+    Buffer(const Buffer &);
+    Buffer & operator=(const Buffer &);
+
     bool true_buffer;
     bool deadlock_detected;
 
@@ -71,15 +98,20 @@ class Buffer {
 
     unsigned int max_buffer_size;
 
-    queue < Flit > buffer;
+    // Ring of a power of two slots, in inline_ring when it fits
+    FlitHandle inline_ring[BUFFER_INLINE_SLOTS];
+    FlitHandle *ring;
+    unsigned int mask;
+    unsigned int head;
+    unsigned int count;
 
+    // Occupancy integral over the cycles after the warm-up
     unsigned int max_occupancy;
-    double hold_time, last_event, hold_time_sum;
-    double mean_occupancy;
-    int    previous_occupancy;
-    
-    void SaveOccupancyAndTime();
-    void UpdateMeanOccupancy();
+    long long last_event;
+    unsigned long long occupancy_cycles;
+    unsigned long long occupancy_sum;
+
+    void UpdateOccupancy();
 };
 
 typedef Buffer BufferBank[MAX_VIRTUAL_CHANNELS];
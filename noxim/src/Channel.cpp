@@ -63,7 +63,7 @@ void Channel::powerManager(unsigned int hub_dst_index, tlm::tlm_generic_payload&
 {
     if (!GlobalParams::use_powermanager) return;
 
-    struct Flit* f = (struct Flit*)trans.get_data_ptr();
+    const Flit* f = &FlitPool::get(*(FlitHandle*)trans.get_data_ptr());
 
     if (f->flit_type==FLIT_TYPE_HEAD)
     {
@@ -0,0 +1,171 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the implementation of the simulation checkpoint
+ */
+
+#include "Checkpoint.h"
+
+#define CHECKPOINT_MAGIC	0x4E58434B
+#define CHECKPOINT_VERSION	7
+
+Checkpoint::Checkpoint(const string & _filename, const bool _saving)
+{
+    filename = _filename;
+    saving = _saving;
+    file.open(filename.c_str(), (saving ? ios::out | ios::trunc : ios::in) | ios::binary);
+    if (!file.is_open()) {
+	cerr << "Error: cannot open checkpoint file " << filename << endl;
+	exit(1);
+    }
+    header();
+}
+
+Checkpoint::~Checkpoint()
+{
+    file.close();
+}
+
+void Checkpoint::check()
+{
+    if (!file) {
+	cerr << "Error: cannot " << (saving ? "write" : "read") << " checkpoint file " << filename << endl;
+	exit(1);
+    }
+}
+
+void Checkpoint::header()
+{
+    unsigned int magic = CHECKPOINT_MAGIC;
+    unsigned int version = CHECKPOINT_VERSION;
+    transfer(magic);
+    transfer(version);
+    if (magic != CHECKPOINT_MAGIC || version != CHECKPOINT_VERSION) {
+	cerr << "Error: " << filename << " is not a checkpoint of this version of Noxim" << endl;
+	exit(1);
+    }
+
+    // The state layout depends on these, everything else may differ
+    // between the run saving the checkpoint and the runs restoring it
+    int dim_x = GlobalParams::mesh_dim_x;
+    int dim_y = GlobalParams::mesh_dim_y;
+    int n_vc = GlobalParams::n_virtual_channels;
+    int depth = GlobalParams::buffer_depth;
+    string traffic = GlobalParams::traffic_distribution;
+    string trace = GlobalParams::netrace_file;
+    transfer(dim_x);
+    transfer(dim_y);
+    transfer(n_vc);
+    transfer(depth);
+    transfer(traffic);
+    transfer(trace);
+    if (dim_x != GlobalParams::mesh_dim_x || dim_y != GlobalParams::mesh_dim_y ||
+	n_vc != GlobalParams::n_virtual_channels || depth != GlobalParams::buffer_depth ||
+	traffic != GlobalParams::traffic_distribution ||
+	(traffic == TRAFFIC_NETRACE && trace != GlobalParams::netrace_file)) {
+	cerr << "Error: checkpoint " << filename << " was saved with a different mesh, buffers or traffic" << endl;
+	exit(1);
+    }
+}
+
+void Checkpoint::close()
+{
+    unsigned int magic = CHECKPOINT_MAGIC;
+    transfer(magic);
+    if (magic != CHECKPOINT_MAGIC) {
+	cerr << "Error: checkpoint " << filename << " does not match this simulation" << endl;
+	exit(1);
+    }
+    file.close();
+}
+
+void Checkpoint::transfer(string & s)
+{
+    unsigned int size = s.size();
+    transfer(size);
+    s.resize(size);
+    if (saving)
+	file.write(s.data(), size);
+    else
+	file.read(&s[0], size);
+    check();
+}
+
+void Checkpoint::transfer(Flit & flit)
+{
+    unsigned int data = flit.payload.data;
+
+    transfer(flit.src_id);
+    transfer(flit.dst_id);
+    transfer(flit.vc_id);
+    transfer(flit.flit_type);
+    transfer(flit.sequence_no);
+    transfer(flit.sequence_length);
+    transfer(data);
+    transfer(flit.timestamp);
+    transfer(flit.hop_no);
+    transfer(flit.use_low_voltage_path);
+    transfer(flit.nt_pkt);
+    flit.payload.data = data;
+}
+
+void Checkpoint::transfer(Packet & packet)
+{
+    transfer(packet.src_id);
+    transfer(packet.dst_id);
+    transfer(packet.vc_id);
+    transfer(packet.timestamp);
+    transfer(packet.size);
+    transfer(packet.flit_left);
+    transfer(packet.use_low_voltage_path);
+    transfer(packet.nt_pkt);
+}
+
+void Checkpoint::definePacket(nt_packet_t* & packet)
+{
+    if (saving) {
+	assert(saved_packets.find(packet) == saved_packets.end());
+	unsigned int index = saved_packets.size() + 1;
+	saved_packets[packet] = index;
+    } else {
+	packet = nt_packet_malloc();
+	restored_packets.push_back(packet);
+    }
+
+    transfer(packet->cycle);
+    transfer(packet->id);
+    transfer(packet->addr);
+    transfer(packet->type);
+    transfer(packet->src);
+    transfer(packet->dst);
+    transfer(packet->node_types);
+    transfer(packet->num_deps);
+
+    if (!saving)
+	packet->deps = packet->num_deps > 0 ? nt_dependency_malloc(packet->num_deps) : NULL;
+    for (unsigned int i = 0; i < packet->num_deps; i++)
+	transfer(packet->deps[i]);
+}
+
+void Checkpoint::transfer(nt_packet_t* & packet)
+{
+    unsigned int index = 0;
+
+    if (saving) {
+	map<nt_packet_t*, unsigned int>::iterator it = saved_packets.find(packet);
+	if (it != saved_packets.end())
+	    index = it->second;
+	transfer(index);
+    } else {
+	transfer(index);
+	if (index > restored_packets.size()) {
+	    cerr << "Error: checkpoint " << filename << " refers to an unknown trace packet" << endl;
+	    exit(1);
+	}
+	packet = index > 0 ? restored_packets[index - 1] : NULL;
+    }
+}
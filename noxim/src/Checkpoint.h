@@ -0,0 +1,143 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the declaration of the simulation checkpoint
+ */
+
+#ifndef __NOXIMCHECKPOINT_H__
+#define __NOXIMCHECKPOINT_H__
+
+#include <fstream>
+#include <map>
+#include <queue>
+#include <type_traits>
+#include <vector>
+#include <systemc.h>
+#include "DataStructs.h"
+#include "nqueue.h"
+#include "Link.h"
+
+using namespace std;
+
+// Binary image of a running simulation. Every component has a single
+// checkpoint() method built out of transfer() calls, which write the state
+// when saving and read it back in the same order when restoring.
+//
+// Netrace packets are shared by the NoC queues, the PE queues, the flits
+// and the netrace dependency table: each one is stored once and referenced
+// by its index afterwards, so a restored run gets one fresh copy of every
+// packet with all its references pointing to it.
+class Checkpoint {
+
+  public:
+
+    Checkpoint(const string & filename, const bool saving);
+    ~Checkpoint();
+
+    // Ends the image. When restoring, checks that everything saved has
+    // been read back.
+    void close();
+
+    bool isSaving() const {
+	return saving;
+    }
+
+    // Plain data
+    template <typename T> void transfer(T & value)
+    {
+	static_assert(is_trivially_copyable<T>::value, "no checkpoint transfer for this type");
+	if (saving)
+	    file.write((const char *) &value, sizeof(T));
+	else
+	    file.read((char *) &value, sizeof(T));
+	check();
+    }
+
+    template <typename T> void transfer(vector<T> & v)
+    {
+	unsigned int size = v.size();
+	transfer(size);
+	v.resize(size);
+	for (unsigned int i = 0; i < size; i++)
+	    transfer(v[i]);
+    }
+
+    // Queues are rotated once while saving, so their order is kept
+    template <typename T> void transfer(queue<T> & q)
+    {
+	unsigned int size = q.size();
+	transfer(size);
+	if (!saving)
+	    q = queue<T>();
+	for (unsigned int i = 0; i < size; i++) {
+	    T item = saving ? q.front() : T();
+	    if (saving)
+		q.pop();
+	    transfer(item);
+	    q.push(item);
+	}
+    }
+
+    template <typename T> void transfer(Queue<T> & q)
+    {
+	unsigned int size = q.get_size();
+	transfer(size);
+	if (!saving)
+	    while (!q.is_empty())
+		q.pop();
+	for (unsigned int i = 0; i < size; i++) {
+	    T item = saving ? q.pop() : T();
+	    transfer(item);
+	    q.push(item);
+	}
+    }
+
+    // Signals are written from outside the simulation: the restored values
+    // are seen by the processes from the first cycle after the restore
+    template <typename T> void transfer(sc_signal<T> & signal)
+    {
+	T value = signal.read();
+	transfer(value);
+	if (!saving)
+	    signal.write(value);
+    }
+
+    template <typename T> void transfer(Link<T> & link)
+    {
+	T value = link.read();
+	transfer(value);
+	if (!saving)
+	    link.set(value);
+    }
+
+    void transfer(string & s);
+    void transfer(Flit & flit);
+    void transfer(Packet & packet);
+
+    // Stores a live trace packet, i.e. one the netrace dependency table
+    // knows about, and gives it an index
+    void definePacket(nt_packet_t* & packet);
+
+    // Reference to a packet stored with definePacket(). Anything else is a
+    // packet freed already (e.g. the last flit left on a link) and comes
+    // back as NULL.
+    void transfer(nt_packet_t* & packet);
+
+  private:
+
+    void check();
+    void header();
+
+    string filename;
+    bool saving;
+    fstream file;
+
+    map<nt_packet_t*, unsigned int> saved_packets;	// packet -> index, while saving
+    vector<nt_packet_t*> restored_packets;		// index -> packet, while restoring
+};
+
+#endif
@@ -50,6 +50,8 @@ void loadConfiguration() {
     GlobalParams::max_packet_size = config["max_packet_size"].as<int>();
     GlobalParams::routing_algorithm = config["routing_algorithm"].as<string>();
     GlobalParams::routing_table_filename = config["routing_table_filename"].as<string>(); 
+    GlobalParams::routing_table_binary = config["routing_table_binary"].as<string>("");
+    GlobalParams::precompute_routing = config["precompute_routing"].as<bool>(false);
     GlobalParams::selection_strategy = config["selection_strategy"].as<string>();
     GlobalParams::packet_injection_rate = config["packet_injection_rate"].as<double>();
     GlobalParams::probability_of_retransmission = config["probability_of_retransmission"].as<double>();
@@ -58,6 +60,11 @@ void loadConfiguration() {
     GlobalParams::netrace_file = config["netrace_file"].as<string>();
     GlobalParams::exp_type = config["exp_type"].as<string>();
     GlobalParams::res_file = config["res_file"].as<string>();
+    GlobalParams::netrace_prefetch_depth = config["netrace_prefetch_depth"].as<int>(0);
+    GlobalParams::netrace_fast_forward = config["netrace_fast_forward"].as<bool>(false);
+    GlobalParams::netrace_sample_regions = config["netrace_sample_regions"].as<vector<int> >(vector<int>());
+    GlobalParams::netrace_sample_window = config["netrace_sample_window"].as<int>(0);
+    GlobalParams::netrace_sample_period = config["netrace_sample_period"].as<int>(0);
 
     GlobalParams::traffic_table_filename = config["traffic_table_filename"].as<string>();
     GlobalParams::clock_period_ps = config["clock_period_ps"].as<int>();
@@ -73,6 +80,11 @@ void loadConfiguration() {
     GlobalParams::show_buffer_stats = config["show_buffer_stats"].as<bool>();
     GlobalParams::use_winoc = config["use_winoc"].as<bool>();
     GlobalParams::use_powermanager = config["use_wirxsleep"].as<bool>();
+    GlobalParams::flat_engine = config["flat_engine"].as<bool>(false);
+    GlobalParams::flat_threads = config["flat_threads"].as<int>(1);
+    GlobalParams::checkpoint_save_file = config["checkpoint_save"].as<string>("");
+    GlobalParams::checkpoint_save_cycle = config["checkpoint_save_cycle"].as<int>(0);
+    GlobalParams::checkpoint_load_file = config["checkpoint_load"].as<string>("");
     
 
     set<int> channelSet;
@@ -194,6 +206,8 @@ void showHelp(char selfname[])
          << "\t\tODD_EVEN\t\tOdd-Even routing algorithm" << endl
          << "\t\tDYAD T\t\tDyAD routing algorithm with threshold T" << endl
          << "\t\tTABLE_BASED FILENAME\tRouting Table Based routing algorithm with table in the specified file" << endl
+         << "\t-routing_table_binary FILE\tKeep a binary image of the TABLE_BASED routing table in FILE, rebuilt when the table changes" << endl
+         << "\t-precompute_routing\tTabulate the deterministic routing algorithms when the mesh is built" << endl
          << "\t-sel TYPE\tSet the selection strategy to one of the following:" << endl
          << "\t\tRANDOM\t\tRandom selection strategy" << endl
          << "\t\tBUFFER_LEVEL\tBuffer-Level Based selection strategy" << endl
@@ -222,7 +236,15 @@ void showHelp(char selfname[])
          << "\t-volume N\tStop the simulation when either the maximum number of cycles has been reached or N flits have" << endl
          << "\t\t\tbeen delivered" << endl
          << "\t-asciimonitor\tShow status of the network while running (experimental)" << endl
+         << "\t-flat_engine\tEvaluate all routers, PEs and hubs from a single process each cycle, over array-backed links" << endl
+         << "\t-flat_threads N\tSplit the mesh of the flat engine into N rectangles evaluated in parallel (not with wireless or -volume)" << endl
+         << "\t-checkpoint_save FILE N\tSave the simulation state to FILE at cycle N and go on (not with wireless or netrace sampling)" << endl
+         << "\t-checkpoint_load FILE\tResume the simulation from the state saved in FILE" << endl
          << "\t-sim N\t\tRun for the specified simulation time [cycles]" << endl
+         << "\t-net_prefetch N\tDecode up to N netrace packets ahead on a background thread (0 disables)" << endl
+         << "\t-net_fastforward\tJump over cycles in which the network is idle until the next trace packet (not with wireless)" << endl
+         << "\t-net_region N\tSimulate netrace region N in detail and extrapolate the rest of the trace (can be repeated)" << endl
+         << "\t-net_sample W P\tSimulate a window of W cycles every P cycles of each sampled region (0 0: whole regions)" << endl
          << endl
          << "If you find this program useful please don't forget to mention in your paper Maurizio Palesi <maurizio.palesi@unikore.it>" << endl
          <<	"If you find this program useless please feel free to complain with Davide Patti <davide.patti@dieei.unict.it>" << endl
@@ -339,6 +361,73 @@ void checkConfiguration()
 	exit(1);
     }
 
+    if (GlobalParams::netrace_prefetch_depth < 0) {
+	cerr << "Error: netrace prefetch depth must be positive" << endl;
+	exit(1);
+    }
+
+    if (GlobalParams::netrace_sample_window < 0 || GlobalParams::netrace_sample_period < 0) {
+	cerr << "Error: netrace sample window and period must be positive" << endl;
+	exit(1);
+    }
+
+    if (GlobalParams::netrace_sample_period > 0 &&
+	GlobalParams::netrace_sample_period < GlobalParams::netrace_sample_window) {
+	cerr << "Error: netrace sample period must not be shorter than the sample window" << endl;
+	exit(1);
+    }
+
+    for (unsigned int i = 0; i < GlobalParams::netrace_sample_regions.size(); i++)
+	if (GlobalParams::netrace_sample_regions[i] < 0) {
+	    cerr << "Error: netrace sample regions must be positive" << endl;
+	    exit(1);
+	}
+
+    if (!GlobalParams::checkpoint_save_file.empty() || !GlobalParams::checkpoint_load_file.empty()) {
+	if (GlobalParams::use_winoc) {
+	    cerr << "Error: checkpoints are not supported with wireless" << endl;
+	    exit(1);
+	}
+	if (!GlobalParams::netrace_sample_regions.empty() || GlobalParams::netrace_sample_window > 0) {
+	    cerr << "Error: checkpoints are not supported with netrace sampling" << endl;
+	    exit(1);
+	}
+    }
+
+    if (!GlobalParams::checkpoint_save_file.empty() &&
+	GlobalParams::checkpoint_save_cycle <= GlobalParams::reset_time) {
+	cerr << "Error: checkpoint cycle must be past the reset" << endl;
+	exit(1);
+    }
+
+    if (GlobalParams::flat_threads < 1 || GlobalParams::flat_threads > GlobalParams::mesh_dim_x * GlobalParams::mesh_dim_y) {
+	cerr << "Error: flat engine threads must be in the range 1..number of tiles" << endl;
+	exit(1);
+    }
+
+    // partitions only exchange link values, the wireless side and the
+    // drained volume are shared by the whole network
+    if (GlobalParams::flat_threads > 1) {
+	if (!GlobalParams::flat_engine) {
+	    cerr << "Error: flat engine threads need the flat engine" << endl;
+	    exit(1);
+	}
+	if (GlobalParams::use_winoc) {
+	    cerr << "Error: flat engine threads are not supported with wireless" << endl;
+	    exit(1);
+	}
+	if (GlobalParams::max_volume_to_be_drained > 0) {
+	    cerr << "Error: flat engine threads are not supported with a volume to be drained" << endl;
+	    exit(1);
+	}
+    }
+
+    // the flat engine keeps link values out of the signals VCD tracing reads
+    if (GlobalParams::flat_engine && GlobalParams::trace_mode) {
+	cerr << "Error: VCD tracing is not supported with the flat engine" << endl;
+	exit(1);
+    }
+
     if (GlobalParams::locality<0 || GlobalParams::locality>1)
     {
 	cerr << "Error: traffic locality must be in the range 0..1" << endl;
@@ -434,6 +523,10 @@ void parseCmdLine(int arg_num, char *arg_vet[])
 		    GlobalParams::packet_injection_rate = 0;
 		} 
 	    } 
+	    else if (!strcmp(arg_vet[i], "-routing_table_binary"))
+		GlobalParams::routing_table_binary = arg_vet[++i];
+	    else if (!strcmp(arg_vet[i], "-precompute_routing"))
+		GlobalParams::precompute_routing = true;
 	    else if (!strcmp(arg_vet[i], "-sel")) {
 		GlobalParams::selection_strategy = arg_vet[++i];
 	    } 
@@ -512,6 +605,16 @@ void parseCmdLine(int arg_num, char *arg_vet[])
 			char* trace_file = arg_vet[++i];
 			GlobalParams::netrace_file = trace_file;
 		}
+		else if (!strcmp(arg_vet[i], "-net_prefetch"))
+			GlobalParams::netrace_prefetch_depth = atoi(arg_vet[++i]);
+		else if (!strcmp(arg_vet[i], "-net_fastforward"))
+			GlobalParams::netrace_fast_forward = true;
+		else if (!strcmp(arg_vet[i], "-net_region"))
+			GlobalParams::netrace_sample_regions.push_back(atoi(arg_vet[++i]));
+		else if (!strcmp(arg_vet[i], "-net_sample")) {
+			GlobalParams::netrace_sample_window = atoi(arg_vet[++i]);
+			GlobalParams::netrace_sample_period = atoi(arg_vet[++i]);
+		}
 		
 	    else if (!strcmp(arg_vet[i], "-hs")) 
 	    {
@@ -535,6 +638,16 @@ void parseCmdLine(int arg_num, char *arg_vet[])
 		GlobalParams::simulation_time = atoi(arg_vet[++i]);
 	    else if (!strcmp(arg_vet[i], "-asciimonitor")) 
 		GlobalParams::ascii_monitor = true;
+	    else if (!strcmp(arg_vet[i], "-flat_engine"))
+		GlobalParams::flat_engine = true;
+	    else if (!strcmp(arg_vet[i], "-flat_threads"))
+		GlobalParams::flat_threads = atoi(arg_vet[++i]);
+	    else if (!strcmp(arg_vet[i], "-checkpoint_save")) {
+		GlobalParams::checkpoint_save_file = arg_vet[++i];
+		GlobalParams::checkpoint_save_cycle = atoi(arg_vet[++i]);
+	    }
+	    else if (!strcmp(arg_vet[i], "-checkpoint_load"))
+		GlobalParams::checkpoint_load_file = arg_vet[++i];
 	    else if (!strcmp(arg_vet[i], "-config") || !strcmp(arg_vet[i], "-power"))
 		// -config is managed from configure function
 		// i++ skips the configuration file name 
@@ -47,7 +47,7 @@ struct Packet {
     int src_id;
     int dst_id;
     int vc_id;
-    double timestamp;		// SC timestamp at packet generation
+    long long timestamp;	// Cycle of packet generation
     int size;
     int flit_left;		// Number of remaining flits inside the packet
     bool use_low_voltage_path;
@@ -55,11 +55,11 @@ struct Packet {
     // Constructors
     Packet() { }
 
-    Packet(const int s, const int d, const int vc, const double ts, const int sz) {
+    Packet(const int s, const int d, const int vc, const long long ts, const int sz) {
 	make(s, d, vc, ts, sz);
     }
 
-    void make(const int s, const int d, const int vc, const double ts, const int sz) {
+    void make(const int s, const int d, const int vc, const long long ts, const int sz) {
 	src_id = s;
 	dst_id = d;
 	vc_id = vc;
@@ -130,7 +130,7 @@ struct Flit {
     int sequence_no;		// The sequence number of the flit inside the packet
     int sequence_length;
     Payload payload;	// Optional payload
-    double timestamp;		// Unix timestamp at packet generation
+    long long timestamp;	// Cycle of packet generation
     int hop_no;			// Current number of hops from source to destination
     bool use_low_voltage_path;
     nt_packet_t* nt_pkt;
@@ -147,6 +147,11 @@ struct Flit {
 		&& flit.nt_pkt == nt_pkt);
 }};
 
+// FlitHandle -- Index of a flit in the FlitPool. This is what links and
+// buffers carry, so a hop copies and compares a single word.
+typedef unsigned int FlitHandle;
+#define NO_FLIT 0
+
 
 typedef struct 
 {
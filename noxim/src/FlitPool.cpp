@@ -0,0 +1,107 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the implementation of the flit pool
+ */
+
+#include "FlitPool.h"
+#include "Checkpoint.h"
+
+Flit *FlitPool::chunks[FLIT_POOL_MAX_CHUNKS];
+unsigned int FlitPool::size = 1;
+vector<FlitHandle> FlitPool::free_handles;
+vector<FlitPool::FreeList> FlitPool::thread_free_lists(1);
+thread_local int FlitPool::thread_index = 0;
+mutex FlitPool::free_lock;
+
+FlitHandle FlitPool::alloc(const Flit & flit)
+{
+    vector<FlitHandle> & own = thread_free_lists[thread_index].handles;
+
+    if (own.empty())
+	refill(own);
+    FlitHandle handle = own.back();
+    own.pop_back();
+
+    get(handle) = flit;
+    return handle;
+}
+
+void FlitPool::release(const FlitHandle handle)
+{
+    assert(handle != NO_FLIT && chunks[handle >> FLIT_POOL_CHUNK_BITS] != NULL);
+    vector<FlitHandle> & own = thread_free_lists[thread_index].handles;
+
+    own.push_back(handle);
+    // a thread that consumes more flits than it generates hands the
+    // surplus over to the others
+    if (own.size() > 2 * FLIT_POOL_CHUNK_SIZE) {
+	lock_guard<mutex> guard(free_lock);
+	free_handles.insert(free_handles.end(), own.end() - FLIT_POOL_CHUNK_SIZE, own.end());
+	own.resize(own.size() - FLIT_POOL_CHUNK_SIZE);
+    }
+}
+
+// Takes up to a chunk of slots from the shared list, or the next chunk
+void FlitPool::refill(vector<FlitHandle> & own)
+{
+    lock_guard<mutex> guard(free_lock);
+
+    if (!free_handles.empty()) {
+	unsigned int n = min((unsigned int) free_handles.size(), (unsigned int) FLIT_POOL_CHUNK_SIZE);
+	own.assign(free_handles.end() - n, free_handles.end());
+	free_handles.resize(free_handles.size() - n);
+	return;
+    }
+
+    unsigned int chunk = size >> FLIT_POOL_CHUNK_BITS;
+    assert(chunk < FLIT_POOL_MAX_CHUNKS);
+    if (chunks[chunk] == NULL)
+	chunks[chunk] = new Flit[FLIT_POOL_CHUNK_SIZE]();
+
+    // lowest handles on top, they are handed out first
+    unsigned int end = (chunk + 1) << FLIT_POOL_CHUNK_BITS;
+    for (FlitHandle handle = end; handle-- > size;)
+	own.push_back(handle);
+    size = end;
+}
+
+void FlitPool::setThreads(const int threads)
+{
+    gather();
+    thread_free_lists.resize(threads);
+}
+
+void FlitPool::enterThread(const int thread)
+{
+    thread_index = thread;
+}
+
+// Moves the lists of all threads to the shared one, while no other thread
+// runs
+void FlitPool::gather()
+{
+    for (unsigned int t = 0; t < thread_free_lists.size(); t++) {
+	vector<FlitHandle> & own = thread_free_lists[t].handles;
+	free_handles.insert(free_handles.end(), own.begin(), own.end());
+	own.clear();
+    }
+}
+
+void FlitPool::checkpoint(Checkpoint & cp)
+{
+    // Released slots are saved too: a link keeps showing the handle of the
+    // last flit it carried
+    gather();
+    cp.transfer(size);
+    for (unsigned int chunk = 0; chunk << FLIT_POOL_CHUNK_BITS < size; chunk++)
+	if (chunks[chunk] == NULL)
+	    chunks[chunk] = new Flit[FLIT_POOL_CHUNK_SIZE]();
+    for (FlitHandle handle = 1; handle < size; handle++)
+	cp.transfer(get(handle));
+    cp.transfer(free_handles);
+}
@@ -0,0 +1,72 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the declaration of the flit pool
+ */
+
+#ifndef __NOXIMFLITPOOL_H__
+#define __NOXIMFLITPOOL_H__
+
+#include <cassert>
+#include <mutex>
+#include <vector>
+#include "DataStructs.h"
+
+using namespace std;
+
+class Checkpoint;
+
+#define FLIT_POOL_CHUNK_BITS	10
+#define FLIT_POOL_CHUNK_SIZE	(1 << FLIT_POOL_CHUNK_BITS)
+#define FLIT_POOL_MAX_CHUNKS	(1 << 16)
+
+// Storage of every flit in flight. A flit is written once by the PE that
+// generates it and released by the PE that consumes it; links and buffers
+// only move its FlitHandle around.
+//
+// Slots are allocated in fixed chunks and never move, so a reference
+// returned by get() stays valid while the flit is alive.
+//
+// Each thread of the flat engine allocates from and releases to a free list
+// of its own; only refilling it, or giving back its surplus, goes through
+// the shared list under a lock.
+class FlitPool {
+
+  public:
+
+    static FlitHandle alloc(const Flit & flit);
+    static void release(const FlitHandle handle);
+
+    static inline Flit & get(const FlitHandle handle) {
+	assert(handle != NO_FLIT && chunks[handle >> FLIT_POOL_CHUNK_BITS] != NULL);
+	return chunks[handle >> FLIT_POOL_CHUNK_BITS][handle & (FLIT_POOL_CHUNK_SIZE - 1)];
+    }
+
+    static void setThreads(const int threads);	// Before any other thread uses the pool
+    static void enterThread(const int thread);	// Called by each thread, 0 is the main one
+
+    static void checkpoint(Checkpoint & cp);	// Save or restore all the slots
+
+  private:
+
+    static void refill(vector<FlitHandle> & own);
+    static void gather();
+
+    static Flit *chunks[FLIT_POOL_MAX_CHUNKS];
+    static unsigned int size;			// slots handed out so far, slot 0 is NO_FLIT
+    static vector<FlitHandle> free_handles;	// shared, under lock
+    // free list of each thread, padded to keep them off each other's cache lines
+    struct FreeList {
+	vector<FlitHandle> handles;
+	char padding[64];
+    };
+    static vector<FreeList> thread_free_lists;
+    static thread_local int thread_index;
+    static mutex free_lock;			// guards free_handles and size
+};
+
+#endif
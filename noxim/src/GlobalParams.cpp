@@ -36,6 +36,11 @@ string GlobalParams::power_config_filename;
 string GlobalParams::netrace_file;
 string GlobalParams::exp_type;
 string GlobalParams::res_file;
+int GlobalParams::netrace_prefetch_depth;
+bool GlobalParams::netrace_fast_forward;
+vector <int> GlobalParams::netrace_sample_regions;
+int GlobalParams::netrace_sample_window;
+int GlobalParams::netrace_sample_period;
 
 int GlobalParams::clock_period_ps;
 int GlobalParams::simulation_time;
@@ -50,6 +55,13 @@ vector <pair <int, double> > GlobalParams::hotspots;
 bool GlobalParams::show_buffer_stats;
 bool GlobalParams::use_winoc;
 bool GlobalParams::use_powermanager;
+bool GlobalParams::flat_engine;
+int GlobalParams::flat_threads;
+bool GlobalParams::precompute_routing;
+string GlobalParams::routing_table_binary;
+string GlobalParams::checkpoint_save_file;
+int GlobalParams::checkpoint_save_cycle;
+string GlobalParams::checkpoint_load_file;
 ChannelConfig GlobalParams::default_channel_configuration;
 map<int, ChannelConfig> GlobalParams::channel_configuration;
 HubConfig GlobalParams::default_hub_configuration;
@@ -32,6 +32,9 @@ using namespace std;
 #define DIRECTION_HUB           5
 #define DIRECTION_WIRELESS    747
 
+// Set of directions as a bitmask, see RoutingAlgorithm::route()
+#define DIRECTION_MASK(d)       (1u << (d))
+
 #define MAX_VIRTUAL_CHANNELS	8
 #define DEFAULT_VC 		0
 
@@ -156,6 +159,11 @@ struct GlobalParams {
     static string netrace_file;
     static string exp_type;
     static string res_file;
+    static int netrace_prefetch_depth;
+    static bool netrace_fast_forward;
+    static vector <int> netrace_sample_regions;
+    static int netrace_sample_window;
+    static int netrace_sample_period;
     
     static string config_filename;
     static string power_config_filename;
@@ -172,6 +180,13 @@ struct GlobalParams {
     static bool show_buffer_stats;
     static bool use_winoc;
     static bool use_powermanager;
+    static bool flat_engine;
+    static int flat_threads;
+    static bool precompute_routing;
+    static string routing_table_binary;
+    static string checkpoint_save_file;
+    static int checkpoint_save_cycle;
+    static string checkpoint_load_file;
     static ChannelConfig default_channel_configuration;
     static map<int, ChannelConfig> channel_configuration;
     static HubConfig default_hub_configuration;
@@ -9,6 +9,9 @@
  */
 
 #include "GlobalRoutingTable.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 using namespace std;
 
 LinkId direction2ILinkId(const int node_id, const int dir)
@@ -44,11 +47,10 @@ LinkId direction2ILinkId(const int node_id, const int dir)
     return LinkId(node_src, node_id);
 }
 
-int oLinkId2Direction(const LinkId & out_link)
+// Direction of the link src->dst as seen from src, -1 if the two nodes
+// are not adjacent
+static int linkDirection(const int src, const int dst)
 {
-    int src = out_link.first;
-    int dst = out_link.second;
-
     if (dst == src)
 	return DIRECTION_LOCAL;
     else if (dst == src + 1)
@@ -59,36 +61,87 @@ int oLinkId2Direction(const LinkId & out_link)
 	return DIRECTION_NORTH;
     else if (dst == src + GlobalParams::mesh_dim_x)
 	return DIRECTION_SOUTH;
-    else
-	assert(false);
-    return 0;
+    return -1;
 }
 
-vector <
-    int >admissibleOutputsSet2Vector(const AdmissibleOutputs & ao)
+int iLinkId2Direction(const int node_id, const LinkId & in_link)
 {
-    vector < int >dirs;
+    if (in_link.second != node_id)
+	return -1;
 
-    for (AdmissibleOutputs::iterator i = ao.begin(); i != ao.end();
-	 i++)
-	dirs.push_back(oLinkId2Direction(*i));
-
-    return dirs;
+    // The direction the link comes from is the one it leaves node_id by
+    return linkDirection(node_id, in_link.first);
 }
 
 GlobalRoutingTable::GlobalRoutingTable()
 {
+    masks = NULL;
+    image = NULL;
+    image_size = 0;
+    n_nodes = 0;
     valid = false;
 }
 
+GlobalRoutingTable::~GlobalRoutingTable()
+{
+    unmap();
+}
+
+void GlobalRoutingTable::unmap()
+{
+    if (image != NULL)
+	munmap(image, image_size);
+    image = NULL;
+    image_size = 0;
+}
+
 bool GlobalRoutingTable::load(const char *fname)
+{
+    unmap();
+
+    if (!parse(fname))
+	return false;
+
+    masks = &table[0];
+    valid = true;
+
+    return true;
+}
+
+bool GlobalRoutingTable::load(const char *fname, const char *image_fname)
+{
+    struct stat source;
+
+    if (stat(fname, &source) != 0)
+	return false;
+
+    unmap();
+
+    if (mapImage(image_fname, source)) {
+	table.clear();
+	valid = true;
+	return true;
+    }
+
+    if (!load(fname))
+	return false;
+
+    if (!save(image_fname, source))
+	cerr << "WARNING: cannot write routing table image "
+	     << image_fname << endl;
+
+    return true;
+}
+
+bool GlobalRoutingTable::parse(const char *fname)
 {
     ifstream fin(fname, ios::in);
 
     if (!fin)
 	return false;
 
-    rt_noc.clear();
+    n_nodes = GlobalParams::mesh_dim_x * GlobalParams::mesh_dim_y;
+    table.assign((size_t) n_nodes * (DIRECTIONS + 1) * n_nodes, 0);
 
     bool stop = false;
     while (!fin.eof() && !stop) {
@@ -104,15 +157,26 @@ bool GlobalRoutingTable::load(const char *fname)
 		if (sscanf
 		    (line + 1, "%d %d->%d %d", &node_id, &in_src, &in_dst,
 		     &dst_id) == 4) {
-		    LinkId lin(in_src, in_dst);
+		    // Entries of nodes, links or destinations outside the
+		    // mesh could never be looked up
+		    int dir_in = iLinkId2Direction(node_id, LinkId(in_src, in_dst));
+		    if (node_id < 0 || node_id >= n_nodes || dir_in < 0 ||
+			dst_id < 0 || dst_id >= n_nodes)
+			continue;
+
+		    unsigned char & entry =
+			table[((size_t) node_id * (DIRECTIONS + 1) + dir_in) * n_nodes + dst_id];
 
 		    char *pstr = line + COLUMN_AOC;
 		    while (sscanf(pstr, "%d->%d", &out_src, &out_dst) == 2) {
-			LinkId lout(out_src, out_dst);
+			int dir_out = out_src == node_id ? linkDirection(out_src, out_dst) : -1;
 
-			rt_noc[node_id][lin][dst_id].insert(lout);
+			if (dir_out >= 0)
+			    entry |= DIRECTION_MASK(dir_out);
 
 			pstr = strstr(pstr, ",");
+			if (pstr == NULL)
+			    break;
 			pstr++;
 		    }
 		}
@@ -120,13 +184,75 @@ bool GlobalRoutingTable::load(const char *fname)
 	}
     }
 
-    valid = true;
-
     return true;
 }
 
-RoutingTableNode GlobalRoutingTable::
-getNodeRoutingTable(const int node_id)
+bool GlobalRoutingTable::save(const char *image_fname,
+			      const struct stat & source) const
+{
+    RoutingTableImageHeader header;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = ROUTING_TABLE_IMAGE_MAGIC;
+    header.version = ROUTING_TABLE_IMAGE_VERSION;
+    header.mesh_dim_x = GlobalParams::mesh_dim_x;
+    header.mesh_dim_y = GlobalParams::mesh_dim_y;
+    header.source_size = source.st_size;
+    header.source_mtime = source.st_mtime;
+
+    FILE *f = fopen(image_fname, "wb");
+    if (f == NULL)
+	return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+	fwrite(&table[0], 1, table.size(), f) == table.size();
+
+    if (fclose(f) != 0)
+	ok = false;
+    if (!ok)
+	remove(image_fname);
+
+    return ok;
+}
+
+bool GlobalRoutingTable::mapImage(const char *image_fname,
+				  const struct stat & source)
 {
-    return rt_noc[node_id];
+    int fd = open(image_fname, O_RDONLY);
+    if (fd < 0)
+	return false;
+
+    int nodes = GlobalParams::mesh_dim_x * GlobalParams::mesh_dim_y;
+    size_t size = sizeof(RoutingTableImageHeader) +
+	(size_t) nodes * (DIRECTIONS + 1) * nodes;
+    struct stat st;
+
+    // A stale or foreign image is simply rebuilt
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size != size) {
+	close(fd);
+	return false;
+    }
+
+    void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+	return false;
+
+    const RoutingTableImageHeader *header = (const RoutingTableImageHeader *) p;
+    if (header->magic != ROUTING_TABLE_IMAGE_MAGIC ||
+	header->version != ROUTING_TABLE_IMAGE_VERSION ||
+	header->mesh_dim_x != GlobalParams::mesh_dim_x ||
+	header->mesh_dim_y != GlobalParams::mesh_dim_y ||
+	header->source_size != (unsigned long long) source.st_size ||
+	header->source_mtime != (long long) source.st_mtime) {
+	munmap(p, size);
+	return false;
+    }
+
+    image = p;
+    image_size = size;
+    masks = (const unsigned char *) p + sizeof(RoutingTableImageHeader);
+    n_nodes = nodes;
+
+    return true;
 }
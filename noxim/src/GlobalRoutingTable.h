@@ -13,57 +13,80 @@
 #define COLUMN_AOC 22
 
 #include <vector>
-#include <map>
-#include <set>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <cassert>
 #include <fstream>
+#include <sys/stat.h>
 #include "DataStructs.h"
 using namespace std;
 
 // Pair of source, destination node
 typedef pair < int, int >LinkId;
 
-// Routing table
-typedef set < LinkId > AdmissibleOutputs;
-
-// Map a destination to a set of admissible outputs
-typedef map < int, AdmissibleOutputs > RoutingTableLink;
-
-// Map an input link to its routing table
-typedef map < LinkId, RoutingTableLink > RoutingTableNode;
-
-// Map a node of the network to its routing table
-typedef map < int, RoutingTableNode > RoutingTableNoC;
-
 // Converts an input direction to a link 
 LinkId direction2ILinkId(const int node_id, const int dir);
 
-// Converts an input direction to a link
-int oLinkId2Direction(const LinkId & out_link);
-
-// Converts a set of output links to a set of directions
-vector <
-    int >admissibleOutputsSet2Vector(const AdmissibleOutputs & ao);
+// Converts a link entering node_id to an input direction, -1 if the
+// link does not enter node_id
+int iLinkId2Direction(const int node_id, const LinkId & in_link);
+
+// Header of the binary image of a routing table. It is followed by the
+// table itself, see GlobalRoutingTable.
+#define ROUTING_TABLE_IMAGE_MAGIC	0x4E585254
+#define ROUTING_TABLE_IMAGE_VERSION	1
+
+struct RoutingTableImageHeader {
+    unsigned int magic;
+    unsigned int version;
+    int mesh_dim_x;
+    int mesh_dim_y;
+    unsigned long long source_size;	// the text table it was built from
+    long long source_mtime;
+};
 
+// Routing tables of all the nodes as a dense array of output masks:
+// entry [node][input direction][destination] has a DIRECTION_MASK() bit
+// for every admissible output, 0 when the table has no entry.
 class GlobalRoutingTable {
 
   public:
 
     GlobalRoutingTable();
+    ~GlobalRoutingTable();
 
     // Load routing table from file. Returns true if ok, false otherwise
     bool load(const char *fname);
 
-    RoutingTableNode getNodeRoutingTable(const int node_id);
+    // Same as load(fname), through the binary image image_fname: the image
+    // is memory-mapped if it was built from the current fname, otherwise
+    // it is rebuilt
+    bool load(const char *fname, const char *image_fname);
+
+    // Table of node_id, see LocalRoutingTable
+    const unsigned char *getNodeRoutingTable(const int node_id) const {
+	return masks + (size_t) node_id * (DIRECTIONS + 1) * n_nodes;
+    }
+
+    int getNodes() const {
+	return n_nodes;
+    }
 
     bool isValid() {
 	return valid;
   } private:
 
-     RoutingTableNoC rt_noc;
+    bool parse(const char *fname);
+    bool save(const char *image_fname, const struct stat & source) const;
+    bool mapImage(const char *image_fname, const struct stat & source);
+    void unmap();
+
+    vector<unsigned char> table;	// parsed from the text file
+    const unsigned char *masks;		// table, or the table in the mapped image
+    void *image;
+    size_t image_size;
+    int n_nodes;
     bool valid;
 
 };
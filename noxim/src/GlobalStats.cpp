@@ -115,6 +115,17 @@ vector < vector < double > > GlobalStats::getMaxDelayMtx()
     return mtx;
 }
 
+LatencyHistogram GlobalStats::getDelayHistogram()
+{
+    LatencyHistogram h;
+
+    for (int y = 0; y < GlobalParams::mesh_dim_y; y++)
+	for (int x = 0; x < GlobalParams::mesh_dim_x; x++)
+	    h.merge(noc->t[x][y]->r->stats.getDelayHistogram());
+
+    return h;
+}
+
 double GlobalStats::getAverageThroughput(const int src_id, const int dst_id)
 {
     Tile *tile = noc->searchNode(dst_id);
@@ -345,6 +356,12 @@ void GlobalStats::showStats(std::ostream & out, bool detailed)
     out << "% Global average delay (cycles): " << getAverageDelay() << endl;
     results["average_delay"] = getAverageDelay();
     out << "% Max delay (cycles): " << getMaxDelay() << endl;
+    LatencyHistogram delays = getDelayHistogram();
+    out << "% Delay percentiles p50/p99/p99.9 (cycles): " << delays.getPercentile(0.5)
+	<< " / " << delays.getPercentile(0.99) << " / " << delays.getPercentile(0.999) << endl;
+    results["delay_p50"] = delays.getPercentile(0.5);
+    results["delay_p99"] = delays.getPercentile(0.99);
+    results["delay_p99.9"] = delays.getPercentile(0.999);
     out << "% Network throughput (flits/cycle): " << getAggregatedThroughput() << endl;
     results["NoC_throughput"] = getAggregatedThroughput();
     out << "% Average IP throughput (flits/cycle/IP): " << getThroughput() << endl;
@@ -352,15 +369,97 @@ void GlobalStats::showStats(std::ostream & out, bool detailed)
     results["energy"] = getTotalPower();
     out << "% \tDynamic energy (J): " << getDynamicPower() << endl;
     out << "% \tStatic energy (J): " << getStaticPower() << endl;
+    savePowerActivity();
 
     if (GlobalParams::show_buffer_stats)
       showBufferStats(out);
+
+    if (!noc->trace_samples.empty())
+      showSampledStats(out);
     
     std::ofstream fout(GlobalParams::res_file);
     fout << results; 
 
 }
 
+// Two-sided 95% quantile of Student's t distribution
+static double tQuantile95(int dof)
+{
+    static const double table[] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+
+    if (dof <= 30)
+	return table[dof - 1];
+    // first order Cornish-Fisher expansion around the normal quantile
+    return 1.960 + 2.372 / dof;
+}
+
+// Weighted mean of the per-window values and the half width of its 95%
+// confidence interval, which is left at 0 when there is a single window
+static void sampleEstimate(const vector < double > & x, const vector < double > & w,
+			   double & mean, double & ci)
+{
+    double sum_w = 0.0, sum_wx = 0.0;
+    for (unsigned int i = 0; i < x.size(); i++) {
+	sum_w += w[i];
+	sum_wx += w[i] * x[i];
+    }
+    mean = sum_wx / sum_w;
+    ci = 0.0;
+
+    int n = x.size();
+    if (n < 2)
+	return;
+    double var = 0.0;
+    for (unsigned int i = 0; i < x.size(); i++)
+	var += (w[i] / sum_w) * (w[i] / sum_w) * (x[i] - mean) * (x[i] - mean);
+    var *= (double) n / (n - 1);
+    ci = tQuantile95(n - 1) * sqrt(var);
+}
+
+void GlobalStats::showSampledStats(std::ostream & out)
+{
+    const vector < TraceSample > & samples = noc->trace_samples;
+    vector < double > delay, delay_w, throughput, energy, cycle_w;
+    unsigned long long simulated = 0;
+
+    for (unsigned int i = 0; i < samples.size(); i++) {
+	unsigned long long cycles = samples[i].end_cycle - samples[i].start_cycle;
+	simulated += cycles;
+	// windows without traffic say nothing about latency
+	if (samples[i].packets > 0) {
+	    delay.push_back(samples[i].delay / samples[i].packets);
+	    delay_w.push_back(samples[i].packet_weight);
+	}
+	throughput.push_back((double) samples[i].flits / cycles);
+	energy.push_back(samples[i].energy / cycles);
+	cycle_w.push_back(samples[i].cycle_weight);
+    }
+
+    double mean, ci;
+    out << "% Sampled netrace estimates (" << samples.size() << " windows, "
+	<< simulated << " of " << noc->trace_cycles << " trace cycles, 95% confidence)" << endl;
+    results["sampled_windows"] = samples.size();
+    if (!delay.empty()) {
+	sampleEstimate(delay, delay_w, mean, ci);
+	out << "% 	Trace average delay (cycles): " << mean << " +/- " << ci << endl;
+	results["sampled_average_delay"] = mean;
+	results["sampled_average_delay_ci"] = ci;
+    }
+    sampleEstimate(throughput, cycle_w, mean, ci);
+    out << "% 	Trace network throughput (flits/cycle): " << mean << " +/- " << ci << endl;
+    results["sampled_NoC_throughput"] = mean;
+    results["sampled_NoC_throughput_ci"] = ci;
+    // energy per trace cycle, scaled to the length of the trace
+    sampleEstimate(energy, cycle_w, mean, ci);
+    out << "% 	Trace total energy (J): " << mean * noc->trace_cycles
+	<< " +/- " << ci * noc->trace_cycles << endl;
+    results["sampled_energy"] = mean * noc->trace_cycles;
+    results["sampled_energy_ci"] = ci * noc->trace_cycles;
+}
+
 void GlobalStats::updatePowerBreakDown(map<string,double> &dst,PowerBreakdown* src)
 {
     for (int i=0;i!=src->size;i++)
@@ -369,10 +468,36 @@ void GlobalStats::updatePowerBreakDown(map<string,double> &dst,PowerBreakdown* s
     }
 }
 
+void GlobalStats::updatePowerActivity(map<string,unsigned long long> &dst, Power & power)
+{
+    PowerBreakdown* dynamic = power.getDynamicPowerBreakDown();
+    PowerBreakdown* leakage = power.getStaticPowerBreakDown();
+
+    for (int i=0;i!=dynamic->size;i++)
+	dst[dynamic->breakdown[i].label]+=power.getDynamicEvents(i);
+    for (int i=0;i!=leakage->size;i++)
+	dst[leakage->breakdown[i].label]+=power.getStaticCycles(i);
+}
+
+void GlobalStats::savePowerActivity()
+{
+    map<string,unsigned long long> activity;
+
+    for (int y = 0; y < GlobalParams::mesh_dim_y; y++)
+	for (int x = 0; x < GlobalParams::mesh_dim_x; x++)
+	    updatePowerActivity(activity, noc->t[x][y]->r->power);
+
+    for (map<int, Hub*>::const_iterator it = noc->hub.begin(); it != noc->hub.end(); ++it)
+	updatePowerActivity(activity, it->second->power);
+
+    for (map<string,unsigned long long>::iterator it = activity.begin(); it != activity.end(); ++it)
+	results["power_activity"][it->first] = it->second;
+}
+
 void GlobalStats::showPowerManagerStats(std::ostream & out)
 {
     std::streamsize p = out.precision();
-    int total_cycles = sc_time_stamp().to_double() / GlobalParams::clock_period_ps - GlobalParams::reset_time;
+    int total_cycles = currentCycle() - GlobalParams::reset_time;
 
     out.precision(4);
 
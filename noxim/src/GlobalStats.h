@@ -49,6 +49,9 @@ class GlobalStats {
     // Returns tha matrix of max delay for any node of the network
      vector < vector < double > > getMaxDelayMtx();
 
+    // Returns the delays of the packets received by all the nodes
+    LatencyHistogram getDelayHistogram();
+
     // Returns the aggregated average throughput (flits/cycles)
     double getAggregatedThroughput();
 
@@ -93,6 +96,9 @@ class GlobalStats {
 
     void showPowerManagerStats(std::ostream & out);
 
+    // Shows the whole-trace estimates of a sampled netrace run
+    void showSampledStats(std::ostream & out);
+
 
 
 #ifdef TESTING
@@ -102,6 +108,10 @@ class GlobalStats {
   private:
     const NoC *noc;
     void updatePowerBreakDown(map<string,double> &dst,PowerBreakdown* src);
+    void updatePowerActivity(map<string,unsigned long long> &dst, Power & power);
+    // Writes the event and unit cycle counts of the whole network to the
+    // results, so that a run can be priced with another power configuration
+    void savePowerActivity();
 };
 
 #endif
@@ -9,6 +9,7 @@
  */
 
 #include "GlobalTrafficTable.h"
+#include <algorithm>
 
 GlobalTrafficTable::GlobalTrafficTable()
 {
@@ -38,7 +39,8 @@ bool GlobalTrafficTable::load(const char *fname)
 	int params =
 	  sscanf(line, "%d %d %lf %lf %d %d %d", &src, &dst, &pir,
 		 &por, &t_on, &t_off, &t_period);
-	if (params >= 2) {
+	// Negative sources match no PE
+	if (params >= 2 && src >= 0) {
 	  // Create a communication from the parameters read on the line
 	  Communication communication;
 
@@ -90,40 +92,85 @@ bool GlobalTrafficTable::load(const char *fname)
     }
   }
 
+  // Group the communications by source, keeping the order of the file
+  // among those of a source
+  stable_sort(traffic_table.begin(), traffic_table.end(), sourceLess);
+
+  int sources = 0;
+  for (unsigned int i = 0; i < traffic_table.size(); i++)
+    sources = max(sources, traffic_table[i].src + 1);
+
+  source_begin.assign(sources + 1, 0);
+  for (unsigned int i = 0; i < traffic_table.size(); i++)
+    source_begin[traffic_table[i].src + 1]++;
+  for (int s = 0; s < sources; s++)
+    source_begin[s + 1] += source_begin[s];
+
+  active.assign(sources, ActiveCommunications());
+  for (int s = 0; s < sources; s++)
+    active[s].from = active[s].until = 0;
+
   return true;
 }
 
-double GlobalTrafficTable::getCumulativePirPor(const int src_id,
-						    const int ccycle,
-						    const bool pir_not_por,
-						    vector < pair < int, double > > &dst_prob)
+bool GlobalTrafficTable::sourceLess(const Communication & a,
+				    const Communication & b)
 {
-  double cpirnpor = 0.0;
-
-  dst_prob.clear();
-
-  for (unsigned int i = 0; i < traffic_table.size(); i++) {
-    Communication comm = traffic_table[i];
-    if (comm.src == src_id) {
-      int r_ccycle = ccycle % comm.t_period;
-      if (r_ccycle > comm.t_on && r_ccycle < comm.t_off) {
-	cpirnpor += pir_not_por ? comm.pir : comm.por;
-	pair < int, double >dp(comm.dst, cpirnpor);
-	dst_prob.push_back(dp);
-      }
+  return a.src < b.src;
+}
+
+void GlobalTrafficTable::updateActive(const int src_id, const int ccycle)
+{
+  ActiveCommunications & ac = active[src_id];
+
+  ac.from = ccycle;
+  ac.until = INT_MAX;
+  ac.cpir = ac.cpor = 0.0;
+  ac.dst_pir.clear();
+  ac.dst_por.clear();
+
+  for (int i = source_begin[src_id]; i < source_begin[src_id + 1]; i++) {
+    const Communication & comm = traffic_table[i];
+    int r_ccycle = ccycle % comm.t_period;
+    int period_start = ccycle - r_ccycle;
+
+    // The set is the same until the first communication starts or
+    // stops, i.e. r_ccycle gets to t_on + 1, t_off or the next period
+    int next;
+    if (r_ccycle <= comm.t_on)
+      next = period_start + comm.t_on + 1;
+    else if (r_ccycle < comm.t_off)
+      next = period_start + comm.t_off;
+    else
+      next = period_start + comm.t_period;
+    ac.until = min(ac.until, next);
+
+    if (r_ccycle > comm.t_on && r_ccycle < comm.t_off) {
+      ac.cpir += comm.pir;
+      ac.dst_pir.push_back(pair < int, double >(comm.dst, ac.cpir));
+      ac.cpor += comm.por;
+      ac.dst_por.push_back(pair < int, double >(comm.dst, ac.cpor));
     }
   }
-
-  return cpirnpor;
 }
 
-int GlobalTrafficTable::occurrencesAsSource(const int src_id)
+double GlobalTrafficTable::getCumulativePirPor(const int src_id,
+						    const int ccycle,
+						    const bool pir_not_por,
+						    const vector < pair < int, double > > * &dst_prob)
 {
-  int count = 0;
+  static const vector < pair < int, double > > none;
 
-  for (unsigned int i = 0; i < traffic_table.size(); i++)
-    if (traffic_table[i].src == src_id)
-      count++;
+  if (occurrencesAsSource(src_id) == 0) {
+    dst_prob = &none;
+    return 0.0;
+  }
+
+  ActiveCommunications & ac = active[src_id];
+  if (ccycle < ac.from || ccycle >= ac.until)
+    updateActive(src_id, ccycle);
+
+  dst_prob = pir_not_por ? &ac.dst_pir : &ac.dst_por;
 
-  return count;
+  return pir_not_por ? ac.cpir : ac.cpor;
 }
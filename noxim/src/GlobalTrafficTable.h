@@ -14,6 +14,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <vector>
+#include <climits>
 #include "DataStructs.h"
 
 using namespace std;
@@ -29,6 +30,17 @@ struct Communication {
   int t_period;		        // Period after which activity starts again
 };
 
+// Communications of a source that are active in a span of cycles, with
+// their cumulative shotting probabilities
+struct ActiveCommunications {
+  int from;			// First cycle of the span
+  int until;			// First cycle past the span
+  double cpir;			// Cumulative pir of the active communications
+  double cpor;			// Cumulative por of the active communications
+  vector < pair < int, double > > dst_pir;
+  vector < pair < int, double > > dst_por;
+};
+
 class GlobalTrafficTable {
 
   public:
@@ -40,19 +52,31 @@ class GlobalTrafficTable {
 
     // Returns the cumulative pir por along with a vector of pairs. The
     // first component of the pair is the destination. The second
-    // component is the cumulative shotting probability.
+    // component is the cumulative shotting probability. dst_prob stays
+    // valid until the next call for src_id.
     double getCumulativePirPor(const int src_id,
 			       const int ccycle,
 			       const bool pir_not_por,
-			       vector < pair < int, double > > &dst_prob);
+			       const vector < pair < int, double > > * &dst_prob);
 
     // Returns the number of occurrences of soruce src_id in the traffic
     // table
-    int occurrencesAsSource(const int src_id);
+    int occurrencesAsSource(const int src_id) const {
+      if (src_id < 0 || src_id + 1 >= (int) source_begin.size())
+	return 0;
+      return source_begin[src_id + 1] - source_begin[src_id];
+    }
 
   private:
 
-     vector < Communication > traffic_table;
+    static bool sourceLess(const Communication & a, const Communication & b);
+
+    // Recomputes the communications of src_id active at ccycle
+    void updateActive(const int src_id, const int ccycle);
+
+     vector < Communication > traffic_table;	// Grouped by source
+     vector < int > source_begin;		// First communication of each source
+     vector < ActiveCommunications > active;	// Per source
 };
 
 #endif
@@ -15,7 +15,7 @@ int Hub::tile2Port(int id)
     return tile2port_mapping[id];
 }
 
-int Hub::route(Flit& f)
+int Hub::route(const Flit& f)
 {
     for (vector<int>::size_type i=0; i< GlobalParams::hub_configuration[local_id].attachedNodes.size();i++)
     {
@@ -88,13 +88,8 @@ void Hub::updateRxPower()
 	power.leakageTransceiverRx();
 	power.biasingRx();
 
-	for (unsigned int i=0;i<rxChannels.size();i++)
-	    for (int vc=0;vc<GlobalParams::n_virtual_channels;vc++)
-		power.leakageAntennaBuffer();
-
-	for (int i = 0; i < num_ports; i++) 
-	    for (int vc=0;vc<GlobalParams::n_virtual_channels;vc++)
-		power.leakageBufferToTile();
+	power.leakageAntennaBuffer(rxChannels.size() * GlobalParams::n_virtual_channels);
+	power.leakageBufferToTile(num_ports * GlobalParams::n_virtual_channels);
     }    
 }
 
@@ -134,9 +129,7 @@ void Hub::updateTxPower()
 	txPowerManager();
     else
     {
-	for (unsigned int i=0;i<txChannels.size();i++)
-	    for (int vc=0;vc<GlobalParams::n_virtual_channels;vc++)
-		power.leakageAntennaBuffer();
+	power.leakageAntennaBuffer(txChannels.size() * GlobalParams::n_virtual_channels);
 
 	power.leakageTransceiverTx();
 	power.biasingTx();
@@ -144,9 +137,7 @@ void Hub::updateTxPower()
 
     // mandatory
     power.leakageLinkRouter2Hub();
-    for (int i = 0; i < num_ports; i++) 
-	    for (int vc=0;vc<GlobalParams::n_virtual_channels;vc++)
-		power.leakageBufferFromTile();
+    power.leakageBufferFromTile(num_ports * GlobalParams::n_virtual_channels);
 }
 
 
@@ -161,7 +152,7 @@ void Hub::txRadioProcessTokenPacket(int channel)
     {
 	if (!init[channel]->buffer_tx.IsEmpty())
 	{
-	    Flit flit = init[channel]->buffer_tx.Front();
+	    const Flit & flit = FlitPool::get(init[channel]->buffer_tx.Front());
 
 	    // TODO: check whether it would make sense to use transmission_in_progress to
 	    // avoid multiple notify()
@@ -280,7 +271,8 @@ void Hub::antennaToTileProcess()
 
 	    if (!buffer_to_tile[i][vc].IsEmpty()) 
 	    {     
-		Flit flit = buffer_to_tile[i][vc].Front();
+		FlitHandle handle = buffer_to_tile[i][vc].Front();
+		const Flit & flit = FlitPool::get(handle);
 
 		LOG << "Flit " << flit << " found on buffer_to_tile[" << i <<"][" << vc << "] " << endl;
 		if (current_level_tx[i] == ack_tx[i].read() &&
@@ -288,7 +280,7 @@ void Hub::antennaToTileProcess()
 		{
 		    LOG << "Flit " << flit << " moved from buffer_to_tile[" << i <<"][" << vc << "] to signal flit_tx["<<i<<"] " << endl;
 
-		    flit_tx[i].write(flit);
+		    flit_tx[i].write(handle);
 		    current_level_tx[i] = 1 - current_level_tx[i];
 		    req_tx[i].write(current_level_tx[i]);
 
@@ -319,7 +311,7 @@ void Hub::antennaToTileProcess()
 
 	if (!(target[channel]->buffer_rx.IsEmpty()))
 	{
-	    Flit received_flit = target[channel]->buffer_rx.Front();
+	    const Flit & received_flit = FlitPool::get(target[channel]->buffer_rx.Front());
 	    power.antennaBufferFront();
 
 	    // Check antenna buffer_rx making appropriate reservations
@@ -361,18 +353,19 @@ void Hub::antennaToTileProcess()
     for (unsigned int i = 0; i < rxChannels.size(); i++) 
     {
 	int channel = rxChannels[i];
-	vector<pair<int,int> > reservations = antenna2tile_reservation_table.getReservations(channel);
+	const vector<pair<int,int> > & reservations = antenna2tile_reservation_table.getReservations(channel);
 
 	if (reservations.size()!=0)
 	{
-	    int rnd_idx = rand()%reservations.size();
+	    int rnd_idx = rng.below(reservations.size());
 
 	    int port = reservations[rnd_idx].first;
 	    int vc = reservations[rnd_idx].second;
 
 	    if (!(target[channel]->buffer_rx.IsEmpty()))
 	    {
-		Flit received_flit = target[channel]->buffer_rx.Front();
+		FlitHandle received_handle = target[channel]->buffer_rx.Front();
+		const Flit & received_flit = FlitPool::get(received_handle);
 		power.antennaBufferFront();
 
 		if ( !buffer_to_tile[port][vc].IsFull() ) 
@@ -381,7 +374,7 @@ void Hub::antennaToTileProcess()
 		    power.antennaBufferPop();
 		    LOG << "*** [Ch" << channel << "] Moving flit  " << received_flit << " from buffer_rx to buffer_to_tile[" << port <<"][" << vc << "]" << endl;
 
-		    buffer_to_tile[port][vc].Push(received_flit);
+		    buffer_to_tile[port][vc].Push(received_handle);
 		    power.bufferToTilePush();
 
 		    if (received_flit.flit_type == FLIT_TYPE_TAIL) 
@@ -477,7 +470,7 @@ void Hub::tileToAntennaProcess()
 	    {
 		LOG << "Reservation: buffer_from_tile[" << i <<"][" << vc << "] not empty " << endl;
 
-		Flit flit = buffer_from_tile[i][vc].Front();
+		const Flit & flit = FlitPool::get(buffer_from_tile[i][vc].Front());
 
 		assert(flit.vc_id == vc);
 
@@ -529,18 +522,19 @@ void Hub::tileToAntennaProcess()
     // 2nd phase: Forwarding
     for (int i = 0; i < num_ports; i++) 
     {
-	  vector<pair<int,int> > reservations = tile2antenna_reservation_table.getReservations(i);
+	  const vector<pair<int,int> > & reservations = tile2antenna_reservation_table.getReservations(i);
 	  
 	  if (reservations.size()!=0)
 	  {
-	      int rnd_idx = rand()%reservations.size();
+	      int rnd_idx = rng.below(reservations.size());
 
 	      int o = reservations[rnd_idx].first;
 	      int vc = reservations[rnd_idx].second;
 
 	      if (!buffer_from_tile[i][vc].IsEmpty()) 
 	      {     
-		  Flit flit = buffer_from_tile[i][vc].Front();
+		  FlitHandle handle = buffer_from_tile[i][vc].Front();
+		  const Flit & flit = FlitPool::get(handle);
 		  // powerFront already accounted in 1st phase
 
 		  assert(r_from_tile[i][vc] == DIRECTION_WIRELESS);
@@ -553,7 +547,7 @@ void Hub::tileToAntennaProcess()
 		      {
 			  buffer_from_tile[i][vc].Pop();
 			  power.bufferFromTilePop();
-			  init[channel]->buffer_tx.Push(flit);
+			  init[channel]->buffer_tx.Push(handle);
 			  power.antennaBufferPush();
 			  if (flit.flit_type == FLIT_TYPE_TAIL) 
 			  {
@@ -585,7 +579,8 @@ void Hub::tileToAntennaProcess()
 
 	if (req_rx[i]->read() == 1 - current_level_rx[i]) 
 	{
-	    Flit received_flit = flit_rx[i]->read();
+	    FlitHandle received_handle = flit_rx[i]->read();
+	    const Flit & received_flit = FlitPool::get(received_handle);
 	    int vc = received_flit.vc_id;
 	    LOG << "Reading " << received_flit << " from signal flit_rx[" << i << "]" << endl;
 
@@ -601,7 +596,7 @@ void Hub::tileToAntennaProcess()
 	    {
 		LOG << "Storing " << received_flit << " on buffer_from_tile[" << i << "][" << vc << "]" << endl;
 
-		buffer_from_tile[i][vc].Push(received_flit);
+		buffer_from_tile[i][vc].Push(received_handle);
 		power.bufferFromTilePush();
 
 		current_level_rx[i] = 1 - current_level_rx[i];
@@ -625,7 +620,7 @@ void Hub::tileToAntennaProcess()
     updateTxPower();
 }
 
-int Hub::selectChannel(int src_hub, int dst_hub) const
+int Hub::selectChannel(int src_hub, int dst_hub)
 {  
     vector<int> & first = GlobalParams::hub_configuration[src_hub].txChannels;
     vector<int> & second = GlobalParams::hub_configuration[dst_hub].rxChannels;
@@ -644,11 +639,11 @@ int Hub::selectChannel(int src_hub, int dst_hub) const
     if (intersection.size()==0) return NOT_VALID;
 
     if (GlobalParams::channel_selection==CHSEL_RANDOM)
-	return intersection[rand()%intersection.size()];
+	return intersection[rng.below(intersection.size())];
     else
 	if (GlobalParams::channel_selection==CHSEL_FIRST_FREE)
 	{
-	    int start_channel = rand()%intersection.size();
+	    int start_channel = rng.below(intersection.size());
 	    int k;
 
 	    for (int i=0;i<intersection.size();i++)
@@ -662,7 +657,7 @@ int Hub::selectChannel(int src_hub, int dst_hub) const
 		}
 	    }
 	    cout << "All channel busy, applying random selection " << endl;
-	    return intersection[rand()%intersection.size()];
+	    return intersection[rng.below(intersection.size())];
 	}
 
     return NOT_VALID;
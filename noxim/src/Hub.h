@@ -21,6 +21,7 @@
 #include "Target.h"
 #include "TokenRing.h"
 #include "Power.h"
+#include "RandomStream.h"
 
 using namespace std;
 
@@ -33,18 +34,19 @@ SC_MODULE(Hub)
     sc_in <bool> reset; // The reset signal for the tile
 
     int local_id; // Unique ID
+    RandomStream rng; // Random numbers of this hub
     TokenRing* token_ring;
     int num_ports;
     vector<int> attachedNodes;
     vector<int> txChannels;
     vector<int> rxChannels;
 
-    sc_in<Flit>* flit_rx;
+    sc_in<FlitHandle>* flit_rx;
     sc_in<bool>* req_rx;
     sc_out<bool>* ack_rx;
     sc_out<TBufferFullStatus>* buffer_full_status_rx;
 
-    sc_out<Flit>* flit_tx;
+    sc_out<FlitHandle>* flit_tx;
     sc_out<bool>* req_tx;	   
     sc_in<bool>* ack_tx;	  
     sc_in<TBufferFullStatus>* buffer_full_status_tx;
@@ -77,7 +79,7 @@ SC_MODULE(Hub)
     void antennaToTileProcess();
     void tileToAntennaProcess();
 
-    int route(Flit&);
+    int route(const Flit&);
     int tile2Port(int);
 
     void setFlitTransmissionCycles(int cycles,int ch_id) {flit_transmission_cycles[ch_id]=cycles;}
@@ -98,7 +100,7 @@ SC_MODULE(Hub)
 
     Hub(sc_module_name nm, int id, TokenRing * tr): sc_module(nm) {
 
-	if (GlobalParams::use_winoc)
+	if (GlobalParams::use_winoc && !GlobalParams::flat_engine)
 	{
 	    SC_METHOD(tileToAntennaProcess);
 	    sensitive << reset;
@@ -120,12 +122,12 @@ SC_MODULE(Hub)
 	antenna2tile_reservation_table.setSize(num_ports);
 	tile2antenna_reservation_table.setSize(txChannels.size());
 
-        flit_rx = new sc_in<Flit>[num_ports];
+        flit_rx = new sc_in<FlitHandle>[num_ports];
         req_rx = new sc_in<bool>[num_ports];
         ack_rx = new sc_out<bool>[num_ports];
         buffer_full_status_rx = new sc_out<TBufferFullStatus>[num_ports];
 
-        flit_tx = new sc_out<Flit>[num_ports];
+        flit_tx = new sc_out<FlitHandle>[num_ports];
         req_tx = new sc_out<bool>[num_ports];
         ack_tx = new sc_in<bool>[num_ports];
         buffer_full_status_tx = new sc_in<TBufferFullStatus>[num_ports];
@@ -196,7 +198,7 @@ SC_MODULE(Hub)
     void rxPowerManager();
     void txPowerManager();
 
-    int selectChannel(int src, int dst) const ;
+    int selectChannel(int src, int dst);
 };
 
 #endif
@@ -25,18 +25,19 @@
 
 	  tlm::tlm_command cmd = tlm::TLM_WRITE_COMMAND;
 	  flit_payload = buffer_tx.Front();
+	  const Flit & flit = FlitPool::get(flit_payload);
 	  
 	  hub->power.antennaBufferFront();
 
-	  int destHub = tile2Hub(flit_payload.dst_id);
-	  LOG << " *** Starting transmission of " << flit_payload << " to reach HUB_" << destHub <<  endl;
+	  int destHub = tile2Hub(flit.dst_id);
+	  LOG << " *** Starting transmission of " << flit << " to reach HUB_" << destHub <<  endl;
 
 	  trans->set_command(cmd);
 	  trans->set_address(destHub);
 
 	  trans->set_data_ptr( reinterpret_cast<unsigned char*>(&flit_payload) );
-	  trans->set_data_length( sizeof(Flit) );
-	  trans->set_streaming_width( sizeof(Flit) ); // = data_length to indicate no streaming
+	  trans->set_data_length( sizeof(FlitHandle) );
+	  trans->set_streaming_width( sizeof(FlitHandle) ); // = data_length to indicate no streaming
 	  trans->set_byte_enable_ptr( 0 ); // 0 indicates unused
 	  trans->set_dmi_allowed( false ); // Mandatory initial value
 	  trans->set_response_status( tlm::TLM_INCOMPLETE_RESPONSE ); // Mandatory initial value
@@ -54,12 +55,12 @@
 	      buffer_tx.Pop();
 	      hub->power.antennaBufferPop();
 
-	      if (flit_payload.flit_type == FLIT_TYPE_HEAD) 
+	      if (flit.flit_type == FLIT_TYPE_HEAD) 
 		  hub->transmission_in_progress[_channel_id] = true;
 
-	      if (flit_payload.flit_type == FLIT_TYPE_TAIL)
+	      if (flit.flit_type == FLIT_TYPE_TAIL)
 	      {
-		  LOG << "*** [Ch"<< _channel_id <<"] tail flit sent " << flit_payload << ", releasing token" << endl;
+		  LOG << "*** [Ch"<< _channel_id <<"] tail flit sent " << flit << ", releasing token" << endl;
 		  hub->flag[_channel_id]->write(RELEASE_CHANNEL);
 		  // TODO: vector for multiple channel
 		  hub->transmission_in_progress[_channel_id] = false;
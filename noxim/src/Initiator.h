@@ -56,7 +56,7 @@ struct Initiator: sc_module
   sc_event start_request_event;
 
   Buffer buffer_tx;
-  Flit flit_payload; 
+  FlitHandle flit_payload;	// the wireless transaction carries the handle
 
     private: 
   int _channel_id;
@@ -0,0 +1,120 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the declaration of the links between components
+ */
+
+#ifndef __NOXIMLINK_H__
+#define __NOXIMLINK_H__
+
+#include <cassert>
+#include <systemc.h>
+
+using namespace std;
+
+// Values of the links of one type for the flat engine, as two arrays: the
+// current values every component reads, and the next values they write.
+// commit() makes the written values current, like the SystemC update phase
+// does for signals, so the order components are evaluated in does not matter.
+template <typename T>
+class LinkBank {
+
+  public:
+
+    LinkBank() : slots(0), current(NULL), next(NULL) {}
+    ~LinkBank() {
+	delete[] current;
+	delete[] next;
+    }
+
+    // Slots are handed out during elaboration, before build()
+    int allocate() {
+	assert(current == NULL);
+	return slots++;
+    }
+
+    void build() {
+	current = new T[slots]();
+	next = new T[slots]();
+    }
+
+    int size() const {
+	return slots;
+    }
+
+    // Makes the values written to slots [begin, end) current
+    void commit(const int begin, const int end) {
+	for (int i = begin; i < end; i++)
+	    current[i] = next[i];
+    }
+
+    void commit() {
+	commit(0, slots);
+    }
+
+    // Sets a slot from outside the evaluation, e.g. on a restore
+    void set(const int slot, const T & value) {
+	current[slot] = next[slot] = value;
+    }
+
+    int slots;
+    T *current;
+    T *next;
+};
+
+// Signal between two components. Normally it is an sc_signal. With the flat
+// engine the one writing it gets a slot of a LinkBank, and reads and writes
+// go to the bank instead of the SystemC kernel: no update requests and no
+// events, NoC::evaluate() calls everything and commits the banks.
+// Links nobody writes (borders of the mesh, ports without hubs) keep their
+// sc_signal value.
+template <typename T>
+class Link : public sc_signal<T> {
+
+  public:
+
+    Link() : bank(NULL), slot(0) {}
+
+    void attach(LinkBank<T> & _bank) {
+	assert(bank == NULL);
+	bank = &_bank;
+	slot = bank->allocate();
+    }
+
+    virtual const T & read() const {
+	if (bank != NULL)
+	    return bank->current[slot];
+	return sc_signal<T>::read();
+    }
+
+    virtual void write(const T & value) {
+	if (bank != NULL)
+	    bank->next[slot] = value;
+	else
+	    sc_signal<T>::write(value);
+    }
+
+    // Written from outside the evaluation (initial values, restore)
+    void set(const T & value) {
+	if (bank != NULL)
+	    bank->set(slot, value);
+	else
+	    sc_signal<T>::write(value);
+    }
+
+    Link & operator=(const T & value) {
+	write(value);
+	return *this;
+    }
+
+  private:
+
+    LinkBank<T> *bank;
+    int slot;
+};
+
+#endif
@@ -21,24 +21,21 @@ class LocalRoutingTable {
     // Constructor
     LocalRoutingTable();
 
-    // Extracts the routing table of node _node_id from the global
-    // routing table rtable
-    void configure(GlobalRoutingTable & rtable, const int _node_id);
+    // Points to the routing table of node _node_id in the global
+    // routing table rtable, which must outlive it
+    void configure(const GlobalRoutingTable & rtable, const int _node_id);
 
-    // Returns the set of admissible output channels for destination
-    // destination_id and input channel in_link
-    AdmissibleOutputs getAdmissibleOutputs(const LinkId &
-						in_link,
-						const int destination_id);
-
-    // Returns the set of admissible output channels for a destination
-    // destination_id and a given input direction
-    AdmissibleOutputs getAdmissibleOutputs(const int in_direction,
-						const int destination_id);
+    // Returns the mask of admissible output directions for a destination
+    // destination_id and a given input direction, 0 if there is none
+    unsigned int getAdmissibleOutputs(const int in_direction,
+				      const int destination_id) const {
+	return rt_node[in_direction * n_nodes + destination_id];
+    }
 
   private:
 
-     RoutingTableNode rt_node;
+    const unsigned char *rt_node;
+    int n_nodes;
     int node_id;
 };
 
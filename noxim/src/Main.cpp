@@ -13,6 +13,7 @@
 #include "GlobalStats.h"
 #include "DataStructs.h"
 #include "GlobalParams.h"
+#include "Checkpoint.h"
 
 #include <csignal>
 
@@ -22,6 +23,10 @@ using namespace std;
 
 // need to be globally visible to allow "-volume" simulation stop
 unsigned int drained_volume;
+unsigned long long skipped_cycles;
+long long trace_cycle_offset;
+long long cycle_base;
+unsigned long long clock_cycles;
 NoC *n;
 
 void signalHandler( int signum )
@@ -29,17 +34,28 @@ void signalHandler( int signum )
     cout << "\b\b  " << endl;
     cout << endl;
     cout << "Current Statistics:" << endl;
-    cout << "(" << sc_time_stamp().to_double() / GlobalParams::clock_period_ps << " sim cycles executed)" << endl;
+    cout << "(" << currentCycle() << " sim cycles executed)" << endl;
     GlobalStats gs(n);
     gs.showStats(std::cout, GlobalParams::detailed);
 }
 
+// Runs the simulation on up to the given cycle
+void runUntil(double cycle)
+{
+    if (cycle > currentCycle())
+	sc_start((cycle - currentCycle()) * GlobalParams::clock_period_ps, SC_PS);
+}
+
 int sc_main(int arg_num, char *arg_vet[])
 {
     signal(SIGQUIT, signalHandler);  
 	
     // TEMP
     drained_volume = 0;
+    skipped_cycles = 0;
+    trace_cycle_offset = 0;
+    cycle_base = 0;
+    clock_cycles = 0;
 
     // Handle command-line arguments
     cout << "\t--------------------------------------------" << endl; 
@@ -98,22 +114,51 @@ int sc_main(int arg_num, char *arg_vet[])
     // Reset the chip and run the simulation
     reset.write(1);
     cout << "Reset for " << (int)(GlobalParams::reset_time) << " cycles... ";
-    srand(GlobalParams::rnd_generator_seed);
-    sc_start(GlobalParams::reset_time, SC_NS);
+    runUntil(GlobalParams::reset_time);
 
     reset.write(0);
     cout << " done! " << endl;
+
+    // pick up where the saving run was, over the state the reset left. The
+    // cycle that releases the reset runs everything sensitive to it once
+    // more, so restore after it, where the saving run had plain cycles.
+    if (!GlobalParams::checkpoint_load_file.empty()) {
+	runUntil(GlobalParams::reset_time + 1);
+	Checkpoint cp(GlobalParams::checkpoint_load_file, false);
+	n->checkpoint(cp);
+	cp.close();
+	cout << " Restored " << GlobalParams::checkpoint_load_file << " at cycle " << currentCycle() << endl;
+    }
+
     cout << " Now running for " << GlobalParams:: simulation_time << " cycles..." << endl;
-    if (GlobalParams::traffic_distribution == TRAFFIC_NETRACE)
-        sc_start();
-    else
-    	sc_start(GlobalParams::simulation_time, SC_NS);
+    bool stopped = false;
+    if (!GlobalParams::checkpoint_save_file.empty()) {
+	runUntil(GlobalParams::checkpoint_save_cycle);
+	stopped = currentCycle() < GlobalParams::checkpoint_save_cycle;
+	if (stopped)
+	    cout << " Simulation stopped before cycle " << GlobalParams::checkpoint_save_cycle << ", no checkpoint saved" << endl;
+	else {
+	    Checkpoint cp(GlobalParams::checkpoint_save_file, true);
+	    n->checkpoint(cp);
+	    cp.close();
+	    cout << " Saved " << GlobalParams::checkpoint_save_file << " at cycle " << currentCycle() << endl;
+	}
+    }
+    if (!stopped) {
+	if (GlobalParams::traffic_distribution == TRAFFIC_NETRACE)
+	    sc_start();
+	else
+	    runUntil(GlobalParams::reset_time + GlobalParams::simulation_time);
+    }
 
     // Close the simulation
     if (GlobalParams::trace_mode) sc_close_vcd_trace_file(tf);
     cout << "Noxim simulation completed.";
     nt_close_trfile();
-    cout << " (" << sc_time_stamp().to_double() / GlobalParams::clock_period_ps << " cycles executed)" << endl;
+    cout << " (" << currentCycle() << " cycles executed";
+    if (skipped_cycles > 0)
+	cout << ", " << skipped_cycles << " idle cycles fast-forwarded";
+    cout << ")" << endl;
     cout << endl;
 
     // Show statistics
@@ -122,7 +167,7 @@ int sc_main(int arg_num, char *arg_vet[])
 
 
     if ((GlobalParams::max_volume_to_be_drained > 0) &&
-	(sc_time_stamp().to_double() / GlobalParams::clock_period_ps - GlobalParams::reset_time >=
+	(currentCycle() - GlobalParams::reset_time >=
 	 GlobalParams::simulation_time)) {
 	cout << endl
          << "WARNING! the number of flits specified with -volume option" << endl
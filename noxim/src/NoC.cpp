@@ -9,14 +9,30 @@
  */
 
 #include "NoC.h"
+#include "GlobalStats.h"
+#include "Checkpoint.h"
+#include <algorithm>
 
 using namespace std;
 
 // declare the C functions I will be using
 extern "C" void nt_open_trfile(const char* );
+extern "C" void nt_init_prefetch( unsigned int );
 extern "C" nt_packet_t*	nt_read_packet( void );
+extern "C" int	nt_try_read_packet( nt_packet_t** );
 extern "C" int	nt_dependencies_cleared( nt_packet_t* );
 extern "C" void	nt_clear_dependencies_free_packet( nt_packet_t* );
+extern "C" void	nt_init_cleared_packets_list();
+extern "C" nt_packet_list_t*	nt_get_cleared_packets_list();
+extern "C" void	nt_empty_cleared_packets_list();
+extern "C" nt_header_t*	nt_get_trheader( void );
+extern "C" void	nt_seek_region( nt_regionhead_t* );
+extern "C" void	nt_seek_cycle( unsigned long long int );
+extern "C" void	nt_packet_free( nt_packet_t* );
+extern "C" unsigned long long int	nt_tell( void );
+extern "C" void	nt_seek_position( unsigned long long int );
+extern "C" void	nt_delete_all_dependencies( void );
+extern "C" nt_dep_ref_node_t*	nt_add_dependency_node( unsigned int );
 
 void NoC::buildMesh()
 {
@@ -113,8 +129,20 @@ void NoC::buildMesh()
 
 
     // Check for routing table availability
-    if (GlobalParams::routing_algorithm == ROUTING_TABLE_BASED)
-	assert(grtable.load(GlobalParams::routing_table_filename.c_str()));
+    if (GlobalParams::routing_algorithm == ROUTING_TABLE_BASED) {
+	bool loaded;
+
+	if (GlobalParams::routing_table_binary.empty())
+	    loaded = grtable.load(GlobalParams::routing_table_filename.c_str());
+	else
+	    loaded = grtable.load(GlobalParams::routing_table_filename.c_str(),
+				  GlobalParams::routing_table_binary.c_str());
+	if (!loaded) {
+	    cerr << "Error: cannot load routing table "
+		 << GlobalParams::routing_table_filename << endl;
+	    exit(1);
+	}
+    }
 
     // Check for traffic table availability
     if (GlobalParams::traffic_distribution == TRAFFIC_TABLE_BASED)
@@ -130,7 +158,7 @@ void NoC::buildMesh()
     req = new sc_signal_NSWEH<bool>*[dimX];
     ack = new sc_signal_NSWEH<bool>*[dimX];
     buffer_full_status = new sc_signal_NSWEH<TBufferFullStatus>*[dimX];
-    flit = new sc_signal_NSWEH<Flit>*[dimX];
+    flit = new sc_signal_NSWEH<FlitHandle>*[dimX];
 
     free_slots = new sc_signal_NSWE<int>*[dimX];
     nop_data = new sc_signal_NSWE<NoP_data>*[dimX];
@@ -139,7 +167,7 @@ void NoC::buildMesh()
         req[i] = new sc_signal_NSWEH<bool>[dimY];
         ack[i] = new sc_signal_NSWEH<bool>[dimY];
 	buffer_full_status[i] = new sc_signal_NSWEH<TBufferFullStatus>[dimY];
-        flit[i] = new sc_signal_NSWEH<Flit>[dimY];
+        flit[i] = new sc_signal_NSWEH<FlitHandle>[dimY];
 
         free_slots[i] = new sc_signal_NSWE<int>[dimY];
         nop_data[i] = new sc_signal_NSWE<NoP_data>[dimY];
@@ -370,6 +398,298 @@ void NoC::asciiMonitor()
     }
 }
 
+template <typename T>
+static void attachLink(LinkBank<T> & bank, sc_out<T> & port)
+{
+    Link<T> * link = dynamic_cast<Link<T> *>(port.get_interface());
+    assert(link != NULL);
+    link->attach(bank);
+}
+
+// Ports are only bound to their links once the elaboration is over
+void NoC::end_of_elaboration()
+{
+    if (GlobalParams::flat_engine) {
+	buildPartitions();
+	attachLinks();
+	startWorkers();
+    }
+}
+
+NoC::~NoC()
+{
+    if (workers.empty())
+	return;
+
+    stopping = true;
+    cycle_started.wait();
+    for (unsigned int p = 0; p < workers.size(); p++)
+	workers[p].join();
+}
+
+// Splits the mesh into flat_threads rectangles of about the same size,
+// cutting as few links as the thread count allows
+void NoC::buildPartitions()
+{
+    const int threads = GlobalParams::flat_threads;
+    const int dim_x = GlobalParams::mesh_dim_x;
+    const int dim_y = GlobalParams::mesh_dim_y;
+    int px = 0;
+    int best_cut = 0;
+
+    for (int x = 1; x <= threads; x++) {
+	if (threads % x != 0 || x > dim_x || threads / x > dim_y)
+	    continue;
+	// links crossing the vertical and the horizontal cuts
+	int cut = (x - 1) * dim_y + (threads / x - 1) * dim_x;
+	if (px == 0 || cut < best_cut) {
+	    px = x;
+	    best_cut = cut;
+	}
+    }
+    if (px == 0) {
+	cerr << "Error: cannot split a " << dim_x << "x" << dim_y << " mesh into " << threads << " rectangles" << endl;
+	exit(1);
+    }
+
+    int py = threads / px;
+    for (int b = 0; b < py; b++)
+	for (int a = 0; a < px; a++) {
+	    Partition p;
+	    p.x0 = a * dim_x / px;
+	    p.x1 = (a + 1) * dim_x / px;
+	    p.y0 = b * dim_y / py;
+	    p.y1 = (b + 1) * dim_y / py;
+	    partitions.push_back(p);
+	}
+}
+
+// Gives a bank slot to every link some router, PE or hub writes. The links
+// of a partition take consecutive slots, so that it commits them on its own.
+void NoC::attachLinks()
+{
+    for (unsigned int n = 0; n < partitions.size(); n++) {
+	Partition & p = partitions[n];
+	p.bool_begin = bool_links.size();
+	p.flit_begin = flit_links.size();
+	p.status_begin = status_links.size();
+	p.slot_begin = slot_links.size();
+	p.nop_begin = nop_links.size();
+
+	for (int j = p.y0; j < p.y1; j++)
+	    for (int i = p.x0; i < p.x1; i++) {
+		Router * r = t[i][j]->r;
+		for (int d = 0; d < DIRECTIONS + 2; d++) {
+		    attachLink(flit_links, r->flit_tx[d]);
+		    attachLink(bool_links, r->req_tx[d]);
+		    attachLink(bool_links, r->ack_rx[d]);
+		    attachLink(status_links, r->buffer_full_status_rx[d]);
+		}
+		for (int d = 0; d < DIRECTIONS + 1; d++)
+		    attachLink(slot_links, r->free_slots[d]);
+		for (int d = 0; d < DIRECTIONS; d++)
+		    attachLink(nop_links, r->NoP_data_out[d]);
+
+		ProcessingElement * pe = t[i][j]->pe;
+		attachLink(flit_links, pe->flit_tx);
+		attachLink(bool_links, pe->req_tx);
+		attachLink(bool_links, pe->ack_rx);
+		attachLink(status_links, pe->buffer_full_status_rx);
+	    }
+
+	p.bool_end = bool_links.size();
+	p.flit_end = flit_links.size();
+	p.status_end = status_links.size();
+	p.slot_end = slot_links.size();
+	p.nop_end = nop_links.size();
+    }
+
+    for (map<int, Hub*>::iterator it = hub.begin(); it != hub.end(); ++it)
+	for (int port = 0; port < it->second->num_ports; port++) {
+	    attachLink(flit_links, it->second->flit_tx[port]);
+	    attachLink(bool_links, it->second->req_tx[port]);
+	    attachLink(bool_links, it->second->ack_rx[port]);
+	    attachLink(status_links, it->second->buffer_full_status_rx[port]);
+	}
+
+    bool_links.build();
+    flit_links.build();
+    status_links.build();
+    slot_links.build();
+    nop_links.build();
+}
+
+void NoC::commitLinks()
+{
+    bool_links.commit();
+    flit_links.commit();
+    status_links.commit();
+    slot_links.commit();
+    nop_links.commit();
+}
+
+void NoC::commitLinks(const Partition & p)
+{
+    bool_links.commit(p.bool_begin, p.bool_end);
+    flit_links.commit(p.flit_begin, p.flit_end);
+    status_links.commit(p.status_begin, p.status_end);
+    slot_links.commit(p.slot_begin, p.slot_end);
+    nop_links.commit(p.nop_begin, p.nop_end);
+}
+
+void NoC::startWorkers()
+{
+    int threads = partitions.size();
+    if (threads == 1)
+	return;
+
+    FlitPool::setThreads(threads);
+    cycle_started.setParties(threads);
+    cycle_evaluated.setParties(threads);
+    cycle_committed.setParties(threads);
+    for (int p = 1; p < threads; p++)
+	workers.push_back(thread(&NoC::runWorker, this, p));
+}
+
+void NoC::runWorker(const int p)
+{
+    FlitPool::enterThread(p);
+    for (;;) {
+	cycle_started.wait();
+	if (stopping)
+	    return;
+	evaluatePartition(partitions[p]);
+	cycle_evaluated.wait();
+	commitLinks(partitions[p]);
+	cycle_committed.wait();
+    }
+}
+
+// Flat engine: one process runs every component of the network in a fixed
+// order. They only talk through links, whose written values are committed
+// after all of them ran, so the order does not change the result.
+// With more partitions, each is evaluated on its own thread at the same
+// time; one commits its links only after all of them read the values of
+// the last cycle, and the next cycle starts after all of them committed.
+void NoC::evaluate()
+{
+    if (workers.empty()) {
+	evaluatePartition(partitions[0]);
+
+	if (GlobalParams::use_winoc) {
+	    for (map<int, Hub*>::iterator it = hub.begin(); it != hub.end(); ++it) {
+		it->second->tileToAntennaProcess();
+		it->second->antennaToTileProcess();
+	    }
+	    token_ring->updateTokens();
+	}
+
+	commitLinks();
+	return;
+    }
+
+    cycle_started.wait();
+    evaluatePartition(partitions[0]);
+    cycle_evaluated.wait();
+    commitLinks(partitions[0]);
+    cycle_committed.wait();
+}
+
+void NoC::evaluatePartition(const Partition & p)
+{
+    for (int j = p.y0; j < p.y1; j++)
+	for (int i = p.x0; i < p.x1; i++) {
+	    t[i][j]->r->process();
+	    t[i][j]->r->perCycleUpdate();
+	    t[i][j]->pe->rxProcess();
+	    t[i][j]->pe->txProcess();
+	}
+}
+
+template <typename T>
+static void checkpointSignals(Checkpoint & cp, sc_signal_NSWE<T> & s)
+{
+    cp.transfer(s.east);
+    cp.transfer(s.west);
+    cp.transfer(s.south);
+    cp.transfer(s.north);
+}
+
+template <typename T>
+static void checkpointSignals(Checkpoint & cp, sc_signal_NSWEH<T> & s)
+{
+    cp.transfer(s.east);
+    cp.transfer(s.west);
+    cp.transfer(s.south);
+    cp.transfer(s.north);
+    cp.transfer(s.to_hub);
+    cp.transfer(s.from_hub);
+}
+
+void NoC::seedRandom(const unsigned int seed)
+{
+    for (int j = 0; j < GlobalParams::mesh_dim_y; j++)
+	for (int i = 0; i < GlobalParams::mesh_dim_x; i++) {
+	    int id = t[i][j]->r->local_id;
+	    t[i][j]->pe->rng.seed(seed, RANDOM_STREAM_PE, id);
+	    t[i][j]->r->rng.seed(seed, RANDOM_STREAM_ROUTER, id);
+	}
+
+    for (map<int, Hub*>::iterator it = hub.begin(); it != hub.end(); it++)
+	it->second->rng.seed(seed, RANDOM_STREAM_HUB, it->first);
+}
+
+void NoC::countCycle()
+{
+    clock_cycles++;
+}
+
+// The trace goes first: it defines the trace packets that queues and flits
+// refer to. Hubs and sampling are not supported (see checkConfiguration).
+void NoC::checkpoint(Checkpoint & cp)
+{
+    // a restored run counts its cycles on from the saved one
+    long long now = currentCycle();
+    cp.transfer(now);
+    cycle_base += now - currentCycle();
+
+    cp.transfer(drained_volume);
+    cp.transfer(skipped_cycles);
+    cp.transfer(trace_cycle_offset);
+
+    checkpointTrace(cp);
+
+    // the flits refer to the trace packets defined above
+    FlitPool::checkpoint(cp);
+
+    for (int i = 0; i <= GlobalParams::mesh_dim_x; i++)
+	for (int j = 0; j <= GlobalParams::mesh_dim_y; j++) {
+	    checkpointSignals(cp, req[i][j]);
+	    checkpointSignals(cp, ack[i][j]);
+	    checkpointSignals(cp, buffer_full_status[i][j]);
+	    checkpointSignals(cp, flit[i][j]);
+	    checkpointSignals(cp, free_slots[i][j]);
+	    checkpointSignals(cp, nop_data[i][j]);
+	}
+
+    for (int i = 0; i < GlobalParams::mesh_dim_x; i++)
+	for (int j = 0; j < GlobalParams::mesh_dim_y; j++) {
+	    Tile * tile = t[i][j];
+	    cp.transfer(tile->free_slots_local);
+	    cp.transfer(tile->free_slots_neighbor_local);
+	    cp.transfer(tile->flit_rx_local);
+	    cp.transfer(tile->req_rx_local);
+	    cp.transfer(tile->ack_rx_local);
+	    cp.transfer(tile->buffer_full_status_rx_local);
+	    cp.transfer(tile->flit_tx_local);
+	    cp.transfer(tile->req_tx_local);
+	    cp.transfer(tile->ack_tx_local);
+	    cp.transfer(tile->buffer_full_status_tx_local);
+	    tile->r->checkpoint(cp);
+	    tile->pe->checkpoint(cp);
+	}
+}
+
 // netrace interface
 
 void NoC::start_trace()
@@ -379,6 +699,14 @@ void NoC::start_trace()
 	{
 		nt_open_trfile(GlobalParams::netrace_file.c_str());
 		cout<<"tracefile opened"<<endl;
+		// have netrace report packets as their last dependency clears
+		nt_init_cleared_packets_list();
+		// decode ahead of the simulation on a separate thread
+		if (GlobalParams::netrace_prefetch_depth > 0)
+			nt_init_prefetch(GlobalParams::netrace_prefetch_depth);
+		// only simulate the sampled windows, if any; the first one
+		// opens with the first cycle after reset
+		planSamples();
 	}
 	else
 	{
@@ -392,25 +720,47 @@ void NoC::trace_tx()
 		//continue;
 	}
 	else{
-		// get a trace packet
-		//cout<<"Reading trace packet ";
-		nt_packet_t* trace_pkt = nt_read_packet();
-
-		if(trace_pkt == NULL && wait_q.is_empty())
+		double sim_now = currentCycle();
+		if (!sample_plan.empty() && !sampling_started)
 		{
-			cout<<"Trace completed"<<endl;
-			sc_stop();
+			// the cycle the reset is released in also runs everything
+			// sensitive to the reset, so like the later windows the
+			// first one opens on a plain clock edge
+			if (sim_now <= GlobalParams::reset_time)
+				return;
+			openSample(sim_now);
+			sampling_started = true;
 		}
-		else if(packets_recv >= 500000){
-			sc_stop();
-		}
-		// check if its dependencies are resolved
-		// if there are dependencies push in wait queue
-		if (trace_pkt != NULL)
+		double now = sim_now + trace_cycle_offset;
+
+		// get every trace packet due by this cycle
+		while (!sample_draining)
 		{
+			if (next_trace_pkt == NULL && !trace_done)
+			{
+				// the prefetch ring never blocks: while its thread is behind
+				// keep polling, injecting the packet late would skew results
+				while (!nt_try_read_packet(&next_trace_pkt))
+					sched_yield();
+				trace_done = (next_trace_pkt == NULL);
+			}
+			// a sampled window ends with the first packet past it
+			if (!sample_plan.empty() &&
+			    (trace_done || next_trace_pkt->cycle >= sample_plan[current_sample].end_cycle))
+			{
+				sample_draining = true;
+				quiescent_cycles = 0;
+				break;
+			}
+			if (next_trace_pkt == NULL || next_trace_pkt->cycle > now)
+				break;
 
+			nt_packet_t* trace_pkt = next_trace_pkt;
+			next_trace_pkt = NULL;
 			//cout<<"NoC trace read: "<<trace_pkt->id<<endl;
 
+			// check if its dependencies are resolved
+			// if there are dependencies push in wait queue
 			if (nt_dependencies_cleared(trace_pkt))
 			{
 				//cout<<"No dependencies found, "<<trace_pkt->id<<" "<<+trace_pkt->src<<" "<<+trace_pkt->dst;
@@ -422,21 +772,240 @@ void NoC::trace_tx()
 			{
 				//cout<<"Dependencies found, pushing them into wait queue "<<trace_pkt->id;
 				//cout<<" Cycle "<<trace_pkt->cycle<<endl;
-				wait_q.push(trace_pkt);
+				wait_q.insert(trace_pkt);
 			}
 		}
-		// check the front of inject queue
-		if(!noc_inject_q.is_empty())
+
+		if (trace_done && wait_q.empty() && sample_plan.empty())
+		{
+			cout<<"Trace completed"<<endl;
+			sc_stop();
+		}
+		else if(packets_recv >= 500000){
+			sc_stop();
+		}
+
+		// send everything injectable to the inject queue of its source PE
+		while (!noc_inject_q.is_empty())
 		{
 			nt_packet_t* nt_pkt = noc_inject_q.pop();
-			// send it to the inject queue of PE
 			//cout<<"sending the packet to its core "<<+nt_pkt->src<<" and destination "<<+nt_pkt->dst<<endl;
 			t[id2Coord(nt_pkt->src).x][id2Coord(nt_pkt->src).y]->pe->inject_q.push(nt_pkt);
 		}
+
+		if (sample_draining && current_sample < sample_plan.size())
+		{
+			// the window is over once its packets have left the network;
+			// like fastForward, wait for two empty cycles
+			if (!isQuiescent())
+				quiescent_cycles = 0;
+			else if (++quiescent_cycles >= 2)
+			{
+				closeSample();
+				if (!openSample(sim_now))
+				{
+					cout<<"Sampled trace completed"<<endl;
+					sc_stop();
+				}
+			}
+		}
+		else if (GlobalParams::netrace_fast_forward)
+			fastForward(now);
 	}
 
 }
 
+void NoC::planSamples()
+{
+	nt_header_t* header = nt_get_trheader();
+	trace_cycles = header->num_cycles;
+	trace_packets = header->num_packets;
+
+	vector<int> regions = GlobalParams::netrace_sample_regions;
+	if (regions.empty() && GlobalParams::netrace_sample_window > 0)
+		for (unsigned int r = 0; r < header->num_regions; r++)
+			regions.push_back(r);
+	if (regions.empty())
+	{
+		if (GlobalParams::netrace_sample_window > 0)
+		{
+			cout<<"Error: the trace has no regions to sample"<<endl;
+			exit(1);
+		}
+		return;
+	}
+
+	// windows are visited in trace order
+	sort(regions.begin(), regions.end());
+	regions.erase(unique(regions.begin(), regions.end()), regions.end());
+	if (regions.back() >= (int) header->num_regions)
+	{
+		cout<<"Error: trace has "<<header->num_regions<<" regions, cannot sample region "<<regions.back()<<endl;
+		exit(1);
+	}
+
+	// regions follow each other in the trace
+	vector<unsigned long long> region_start(header->num_regions, 0);
+	for (unsigned int r = 1; r < header->num_regions; r++)
+		region_start[r] = region_start[r - 1] + header->regions[r - 1].num_cycles;
+
+	unsigned long long simulated = 0;
+	for (unsigned int i = 0; i < regions.size(); i++)
+	{
+		int r = regions[i];
+		nt_regionhead_t* region = &header->regions[r];
+		if (region->num_cycles == 0)
+			continue;
+
+		unsigned long long start = region_start[r];
+		unsigned long long end = start + region->num_cycles;
+		// the last trace cycle carries packets too
+		if (r == (int) header->num_regions - 1)
+			end++;
+		unsigned long long window = GlobalParams::netrace_sample_window;
+		unsigned long long period = GlobalParams::netrace_sample_period;
+		if (window == 0 || window > end - start)
+			window = end - start;
+		if (period == 0)
+			period = end - start;
+
+		unsigned int first = sample_plan.size();
+		for (unsigned long long s = start; s < end; s += period)
+		{
+			TraceSample sample;
+			sample.region = r;
+			sample.start_cycle = s;
+			sample.end_cycle = min(s + window, end);
+			simulated += sample.end_cycle - sample.start_cycle;
+			sample_plan.push_back(sample);
+		}
+		// the windows of a region share what it stands for in the trace
+		unsigned int windows = sample_plan.size() - first;
+		for (unsigned int w = first; w < sample_plan.size(); w++)
+		{
+			sample_plan[w].packet_weight = (double) region->num_packets / windows;
+			sample_plan[w].cycle_weight = (double) region->num_cycles / windows;
+		}
+	}
+
+	if (sample_plan.empty())
+	{
+		cout<<"Error: the sampled netrace regions are empty"<<endl;
+		exit(1);
+	}
+	cout<<"Sampling "<<sample_plan.size()<<" trace windows, "<<simulated
+	    <<" of "<<trace_cycles<<" trace cycles"<<endl;
+}
+
+bool NoC::openSample(double sim_now)
+{
+	// whatever the last window left behind is not simulated
+	for (unordered_set<nt_packet_t*>::iterator it = wait_q.begin(); it != wait_q.end(); ++it)
+		nt_packet_free(*it);
+	wait_q.clear();
+	if (next_trace_pkt != NULL)
+	{
+		nt_packet_free(next_trace_pkt);
+		next_trace_pkt = NULL;
+	}
+	if (current_sample == sample_plan.size())
+		return false;
+
+	// seeking drops all pending dependencies, so the first packets of a
+	// window are released as if their producers had already completed
+	TraceSample & sample = sample_plan[current_sample];
+	nt_header_t* header = nt_get_trheader();
+	nt_seek_region(&header->regions[sample.region]);
+	nt_seek_cycle(sample.start_cycle);
+	trace_done = false;
+	sample_draining = false;
+	quiescent_cycles = 0;
+
+	trace_cycle_offset = (long long) sample.start_cycle - (long long) sim_now;
+	sample_begin = readCounters();
+	return true;
+}
+
+void NoC::closeSample()
+{
+	TraceSample sample = sample_plan[current_sample++];
+	TraceSample counters = readCounters();
+
+	sample.packets = counters.packets - sample_begin.packets;
+	sample.flits = counters.flits - sample_begin.flits;
+	sample.delay = counters.delay - sample_begin.delay;
+	sample.energy = counters.energy - sample_begin.energy;
+	trace_samples.push_back(sample);
+}
+
+TraceSample NoC::readCounters()
+{
+	GlobalStats gs(this);
+	TraceSample counters;
+
+	counters.packets = gs.getReceivedPackets();
+	counters.flits = gs.getReceivedFlits();
+	counters.delay = counters.packets > 0 ? gs.getAverageDelay() * counters.packets : 0.0;
+	counters.energy = gs.getTotalPower();
+	return counters;
+}
+
+bool NoC::isQuiescent()
+{
+	// packets in wait_q can only be released by packets not read yet,
+	// so they do not keep the network busy
+	if (!noc_inject_q.is_empty())
+		return false;
+
+	for (int i=0; i < GlobalParams::mesh_dim_x; i++)
+	{
+		for (int j=0; j < GlobalParams::mesh_dim_y; j++)
+		{
+			ProcessingElement* pe = t[i][j]->pe;
+			if (!pe->inject_q.is_empty() || !pe->eject_q.is_empty() ||
+			    !pe->enc_queue_in.empty() || !pe->dec_queue_in.empty() ||
+			    !pe->packet_queue.empty())
+				return false;
+
+			for (int k = 0; k < DIRECTIONS + 2; k++)
+				for (int vc = 0; vc < GlobalParams::n_virtual_channels; vc++)
+					if (!t[i][j]->r->buffer[k][vc].IsEmpty())
+						return false;
+		}
+	}
+	return true;
+}
+
+void NoC::fastForward(double now)
+{
+	// hubs and wireless channels are not checked for quiescence
+	if (GlobalParams::use_winoc)
+		return;
+
+	if (!isQuiescent())
+	{
+		quiescent_cycles = 0;
+		return;
+	}
+
+	// a flit written to a link in the last cycle is not in any buffer yet,
+	// so wait for the network to stay empty for two cycles
+	if (++quiescent_cycles < 2 || next_trace_pkt == NULL)
+		return;
+
+	// resume one cycle before the next packet is due
+	double skip = next_trace_pkt->cycle - now - 1;
+	if (skip < 1)
+		return;
+
+	skipped_cycles += (unsigned long long) skip;
+	trace_cycle_offset += (long long) skip;
+	for (int i=0; i < GlobalParams::mesh_dim_x; i++)
+		for (int j=0; j < GlobalParams::mesh_dim_y; j++)
+			t[i][j]->r->idleLeakage((unsigned long long) skip);
+	quiescent_cycles = 0;
+}
+
 void NoC::trace_rx()
 {
 	// Iterate through the PEs eject queues, convert the packets into noxim_p
@@ -461,20 +1030,77 @@ void NoC::trace_rx()
 		}
 	}
 
-	// Check if the dependencies in wait queue are resolved, and forward it to the inject queue
-	if (! wait_q.is_empty())
+	// Every waiting packet whose dependencies were cleared above becomes
+	// injectable now, regardless of its position in the trace
+	for (nt_packet_list_t* l = nt_get_cleared_packets_list(); l != NULL; l = l->next)
 	{
-		nt_packet_t* wnt_pkt = wait_q.front();
-		if (nt_dependencies_cleared(wnt_pkt))
+		nt_packet_t* wnt_pkt = l->node_packet;
+		// packets injected straight from the trace are not waiting
+		if (wait_q.erase(wnt_pkt))
 		{
 			//cout<<"Dependencies resolved, "<<+wnt_pkt->src<<" "<<+wnt_pkt->dst;
 			//cout<<" Cycle "<<wnt_pkt->cycle<<endl;
 			noc_inject_q.push(wnt_pkt);
 			packets_sent++;
-			wait_q.pop();
 		}
 	}
+	nt_empty_cleared_packets_list();
 
 
 }
 
+// The reader position and the dependency table. The packets read from the
+// trace and not freed yet are exactly those the table has a node for.
+void NoC::checkpointTrace(Checkpoint & cp)
+{
+	if (GlobalParams::traffic_distribution != TRAFFIC_NETRACE)
+		return;
+
+	unsigned long long position = cp.isSaving() ? nt_tell() : 0;
+	cp.transfer(position);
+	if (!cp.isSaving())
+	{
+		nt_delete_all_dependencies();
+		nt_seek_position(position);
+	}
+
+	// left over from a cycle seek, not tracked yet
+	bool pending = (nt_input_pending != NULL);
+	cp.transfer(pending);
+	if (pending)
+		cp.definePacket(nt_input_pending);
+
+	vector<nt_dep_ref_node_t*> nodes;
+	if (cp.isSaving())
+		for (unsigned int i = 0; i < nt_dependency_array_size; i++)
+			if (nt_dependency_array[i] != NULL)
+				nodes.push_back(nt_dependency_array[i]);
+	unsigned int n_nodes = nodes.size();
+	cp.transfer(n_nodes);
+	for (unsigned int i = 0; i < n_nodes; i++)
+	{
+		unsigned int packet_id = cp.isSaving() ? nodes[i]->packet_id : 0;
+		cp.transfer(packet_id);
+		nt_dep_ref_node_t* node = cp.isSaving() ? nodes[i] : nt_add_dependency_node(packet_id);
+		cp.transfer(node->ref_count);
+		bool read = (node->node_packet != NULL);
+		cp.transfer(read);
+		if (read)
+			cp.definePacket(node->node_packet);
+	}
+	cp.transfer(nt_num_active_packets);
+	cp.transfer(nt_latest_active_packet_cycle);
+	cp.transfer(nt_done_reading);
+
+	cp.transfer(next_trace_pkt);
+	cp.transfer(trace_done);
+	cp.transfer(packets_sent);
+	cp.transfer(packets_recv);
+	cp.transfer(quiescent_cycles);
+	cp.transfer(noc_inject_q);
+
+	vector<nt_packet_t*> waiting(wait_q.begin(), wait_q.end());
+	cp.transfer(waiting);
+	if (!cp.isSaving())
+		wait_q = unordered_set<nt_packet_t*>(waiting.begin(), waiting.end());
+}
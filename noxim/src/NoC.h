@@ -12,36 +12,68 @@
 #define __NOXIMNOC_H__
 
 #include <systemc.h>
+#include <thread>
+#include <unordered_set>
 #include "Tile.h"
 #include "GlobalRoutingTable.h"
 #include "GlobalTrafficTable.h"
 #include "Hub.h"
 #include "Channel.h"
 #include "TokenRing.h"
+#include "Link.h"
+#include "Barrier.h"
 
 extern "C" {
 #include "netrace.h"
 }
 using namespace std;
 
+// A window of the trace simulated in detail when netrace sampling is on,
+// with what it represents of the whole trace and what it measured
+struct TraceSample
+{
+    int region;
+    unsigned long long start_cycle;	// trace cycles [start_cycle, end_cycle)
+    unsigned long long end_cycle;
+    double packet_weight;		// trace packets represented by the window
+    double cycle_weight;		// trace cycles represented by the window
+
+    unsigned int packets;
+    unsigned int flits;
+    double delay;			// sum of packet delays (cycles)
+    double energy;			// J
+};
+
+// Rectangle of the mesh the flat engine evaluates on one thread: tiles
+// [x0, x1) x [y0, y1), and the slots of the links they write in each bank
+struct Partition
+{
+    int x0, x1, y0, y1;
+    int bool_begin, bool_end;
+    int flit_begin, flit_end;
+    int status_begin, status_end;
+    int slot_begin, slot_end;
+    int nop_begin, nop_end;
+};
+
 template <typename T>
 struct sc_signal_NSWE
 {
-    sc_signal<T> east;
-    sc_signal<T> west;
-    sc_signal<T> south;
-    sc_signal<T> north;
+    Link<T> east;
+    Link<T> west;
+    Link<T> south;
+    Link<T> north;
 };
 
 template <typename T>
 struct sc_signal_NSWEH
 {
-    sc_signal<T> east;
-    sc_signal<T> west;
-    sc_signal<T> south;
-    sc_signal<T> north;
-    sc_signal<T> to_hub;
-    sc_signal<T> from_hub;
+    Link<T> east;
+    Link<T> west;
+    Link<T> south;
+    Link<T> north;
+    Link<T> to_hub;
+    Link<T> from_hub;
 };
 
 
@@ -55,12 +87,19 @@ SC_MODULE(NoC)
     sc_signal_NSWEH<bool> **req;
     sc_signal_NSWEH<bool> **ack;
     sc_signal_NSWEH<TBufferFullStatus> **buffer_full_status;
-    sc_signal_NSWEH<Flit> **flit;
+    sc_signal_NSWEH<FlitHandle> **flit;
     sc_signal_NSWE<int> **free_slots;
 
     // NoP
     sc_signal_NSWE<NoP_data> **nop_data;
 
+    // Link values with the flat engine, see Link
+    LinkBank<bool> bool_links;		// req and ack
+    LinkBank<FlitHandle> flit_links;
+    LinkBank<TBufferFullStatus> status_links;
+    LinkBank<int> slot_links;		// free_slots
+    LinkBank<NoP_data> nop_links;
+
     // Matrix of tiles
     Tile ***t;
 
@@ -76,20 +115,51 @@ SC_MODULE(NoC)
     // for netrace traffic
     int packets_sent;
     int packets_recv;
+    nt_packet_t* next_trace_pkt;	// read from the trace but not due yet
+    bool trace_done;
+    int quiescent_cycles;		// consecutive cycles with the network empty
+
+    // netrace sampling: completed windows and the size of the whole trace
+    vector<TraceSample> trace_samples;
+    unsigned long long trace_cycles;
+    unsigned long long trace_packets;
 
     // Constructor
 
     SC_CTOR(NoC) {
 
+	// before buildMesh(), which starts the trace
+	packets_sent = 0;
+        packets_recv = 0;
+	next_trace_pkt = NULL;
+	trace_done = false;
+	quiescent_cycles = 0;
+	trace_cycles = 0;
+	trace_packets = 0;
+	current_sample = 0;
+	sample_draining = false;
+	sampling_started = false;
+	stopping = false;
+
 	// Build the Mesh
 	buildMesh();
+	seedRandom(GlobalParams::rnd_generator_seed);
 	
 	GlobalParams::channel_selection = CHSEL_RANDOM;
-	packets_sent = 0;
-        packets_recv = 0;
 	// out of yaml configuration (experimental features)
 	//GlobalParams::channel_selection = CHSEL_FIRST_FREE;
 
+	SC_METHOD(countCycle);
+	sensitive << clock.neg();
+	dont_initialize();
+
+	if (GlobalParams::flat_engine)
+	{
+	    SC_METHOD(evaluate);
+	    sensitive << reset;
+	    sensitive << clock.pos();
+	}
+
 	if (GlobalParams::ascii_monitor)
 	{
 	    SC_METHOD(asciiMonitor);
@@ -111,20 +181,61 @@ SC_MODULE(NoC)
 
     }
 
+    ~NoC();
+
     // Support methods
     Tile *searchNode(const int id) const;
 
+    // Saves or restores the whole simulation state, between two cycles
+    void checkpoint(Checkpoint & cp);
+
+    // Restarts the random streams of every PE, router and hub from seed
+    void seedRandom(const unsigned int seed);
+
   private:
 
     void buildMesh();
+    void end_of_elaboration();
+    void buildPartitions();
+    void attachLinks();
+    void commitLinks();
+    void commitLinks(const Partition & p);
+    void startWorkers();
+    void runWorker(const int p);
+    void countCycle();
     void asciiMonitor();
+    void evaluate();
+    void evaluatePartition(const Partition & p);
 
     void start_trace();
     void trace_tx();
     void trace_rx();
-
-
-    Queue<nt_packet_t*> wait_q;
+    bool isQuiescent();
+    void fastForward(double now);
+    void checkpointTrace(Checkpoint & cp);
+
+    void planSamples();
+    bool openSample(double sim_now);
+    void closeSample();
+    TraceSample readCounters();
+
+    // flat engine: the first partition is evaluated by the SystemC
+    // process, every other one by a worker
+    vector<Partition> partitions;
+    vector<thread> workers;
+    Barrier cycle_started, cycle_evaluated, cycle_committed;
+    bool stopping;
+
+    vector<TraceSample> sample_plan;	// windows still to simulate from current_sample
+    unsigned int current_sample;
+    bool sampling_started;
+    bool sample_draining;		// past the window end, waiting for the network to empty
+    TraceSample sample_begin;		// counters when the current window opened
+
+
+    // packets read from the trace that are still blocked on dependencies,
+    // released by trace_rx when netrace reports them cleared
+    unordered_set<nt_packet_t*> wait_q;
     Queue<nt_packet_t*> noc_inject_q;
 };
 
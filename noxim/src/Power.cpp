@@ -11,6 +11,7 @@
 #include <iostream>
 #include "Power.h"
 #include "Utils.h"
+#include "Checkpoint.h"
 #include "systemc.h"
 
 #define W2J(watt) ((watt)*GlobalParams::clock_period_ps*1.0e-12)
@@ -72,6 +73,7 @@ Power::Power()
     sleep_end_cycle = NOT_VALID;
 
     initPowerBreakdown();
+    setUnitEnergies();
 }
 
 void Power::configureRouter(int link_width,
@@ -134,6 +136,8 @@ void Power::configureRouter(int link_width,
     link_r2r_pwr_d= link_width * GlobalParams::power_configuration.linkBitLinePowerConfig[length_r2r].second;
     link_r2h_pwr_s= W2J(link_width * GlobalParams::power_configuration.linkBitLinePowerConfig[length_r2h].first);
     link_r2h_pwr_d= link_width * GlobalParams::power_configuration.linkBitLinePowerConfig[length_r2h].second;
+
+    setUnitEnergies();
 }
 
 void Power::configureHub(int link_width,
@@ -233,105 +237,7 @@ void Power::configureHub(int link_width,
     link_r2h_pwr_s= W2J(link_width * GlobalParams::power_configuration.linkBitLinePowerConfig[length_r2h].first);
     link_r2h_pwr_d= link_width * GlobalParams::power_configuration.linkBitLinePowerConfig[length_r2h].second;
 
-}
-
-
-// Router buffer
-void Power::bufferRouterPush()
-{
-    power_dynamic.breakdown[BUFFER_PUSH_PWR_D].value += buffer_router_push_pwr_d;
-}
-
-void Power::bufferRouterPop()
-{
-    power_dynamic.breakdown[BUFFER_POP_PWR_D].value += buffer_router_pop_pwr_d;
-}
-
-void Power::bufferRouterFront()
-{
-    power_dynamic.breakdown[BUFFER_FRONT_PWR_D].value += buffer_router_front_pwr_d;
-}
-
-// Hub to tile
-void Power::bufferToTilePush()
-{
-    power_dynamic.breakdown[BUFFER_TO_TILE_PUSH_PWR_D].value += buffer_to_tile_push_pwr_d;
-}
-
-void Power::bufferToTilePop()
-{
-    power_dynamic.breakdown[BUFFER_TO_TILE_POP_PWR_D].value += buffer_to_tile_pop_pwr_d;
-}
-
-void Power::bufferToTileFront()
-{
-
-    power_dynamic.breakdown[BUFFER_TO_TILE_FRONT_PWR_D].value += buffer_to_tile_front_pwr_d;
-}
-
-// Hub from tile
-void Power::bufferFromTilePush()
-{
-    power_dynamic.breakdown[BUFFER_FROM_TILE_PUSH_PWR_D].value += buffer_from_tile_push_pwr_d;
-}
-
-void Power::bufferFromTilePop()
-{
-    power_dynamic.breakdown[BUFFER_FROM_TILE_POP_PWR_D].value += buffer_from_tile_pop_pwr_d;
-}
-
-void Power::bufferFromTileFront()
-{
-
-    power_dynamic.breakdown[BUFFER_FROM_TILE_FRONT_PWR_D].value += buffer_from_tile_front_pwr_d;
-}
-
-
-// Antenna buffers (RX/TX)
-void Power::antennaBufferPush()
-{
-    power_dynamic.breakdown[ANTENNA_BUFFER_PUSH_PWR_D].value += antenna_buffer_push_pwr_d;
-}
-
-void Power::antennaBufferPop()
-{
-    power_dynamic.breakdown[ANTENNA_BUFFER_POP_PWR_D].value += antenna_buffer_pop_pwr_d;
-}
-
-void Power::antennaBufferFront()
-{
-    power_dynamic.breakdown[ANTENNA_BUFFER_FRONT_PWR_D].value += antenna_buffer_front_pwr_d;
-}
-
-
-void Power::routing()
-{
-    power_dynamic.breakdown[ROUTING_PWR_D].value += routing_pwr_d;
-}
-
-void Power::selection()
-{
-    power_dynamic.breakdown[SELECTION_PWR_D].value +=selection_pwr_d ;
-}
-
-void Power::crossBar()
-{
-    power_dynamic.breakdown[CROSSBAR_PWR_D].value +=crossbar_pwr_d;
-}
-
-void Power::r2rLink()
-{
-    power_dynamic.breakdown[LINK_R2R_PWR_D].value +=link_r2r_pwr_d;
-}
-
-void Power::r2hLink()
-{
-    power_dynamic.breakdown[LINK_R2H_PWR_D].value +=link_r2h_pwr_d;
-}
-
-void Power::networkInterface()
-{
-    power_dynamic.breakdown[NI_PWR_D].value +=ni_pwr_d;
+    setUnitEnergies();
 }
 
 
@@ -340,7 +246,7 @@ double Power::getDynamicPower()
     double power = 0.0;
     for (int i = 0; i<power_dynamic.size; i++)
     {
-	power+= power_dynamic.breakdown[i].value;
+	power+= events_dynamic[i] * energy_dynamic[i];
     }
 
     return power;
@@ -350,112 +256,92 @@ double Power::getStaticPower()
 {
     double power = 0.0;
     for (int i = 0; i<power_static.size; i++)
-	power+= power_static.breakdown[i].value;
+	power+= cycles_static[i] * energy_static[i];
 
     return power;
 }
 
-
-double Power::attenuation2power(double attenuation)
-{
-    // TODO
-    return attenuation;
-}
-
-
-
-void Power::wirelessTx(int src,int dst,int length)
-{
-    power_dynamic.breakdown[WIRELESS_TX].value += default_tx_energy;
-    return;
-
-    // TODO enable attenuation_map
-
-    pair<int,int> key = pair<int,int>(src,dst);
-    assert(attenuation_map.find(key)!=attenuation_map.end());
-
-    power_dynamic.breakdown[WIRELESS_TX].value += attenuation2power(attenuation_map[key]) * length;
-}
-
-void Power::wirelessDynamicRx()
-{
-    power_dynamic.breakdown[WIRELESS_DYNAMIC_RX_PWR].value += wireless_rx_pwr;
-}
-
-void Power::wirelessSnooping()
+PowerBreakdown* Power::getDynamicPowerBreakDown()
 {
-    power_dynamic.breakdown[WIRELESS_SNOOPING].value += wireless_snooping;
-}
-
+    for (int i = 0; i<power_dynamic.size; i++)
+	power_dynamic.breakdown[i].value = events_dynamic[i] * energy_dynamic[i];
 
-void Power::biasingRx()
-{
-    power_static.breakdown[TRANSCEIVER_RX_PWR_BIASING].value += transceiver_rx_pwr_biasing;
+    return &power_dynamic;
 }
 
-void Power::biasingTx()
+PowerBreakdown* Power::getStaticPowerBreakDown()
 {
-    power_static.breakdown[TRANSCEIVER_TX_PWR_BIASING].value += transceiver_tx_pwr_biasing;
-
+    for (int i = 0; i<power_static.size; i++)
+	power_static.breakdown[i].value = cycles_static[i] * energy_static[i];
+
+    return &power_static;
+}
+
+void Power::setUnitEnergies()
+{
+    energy_dynamic[BUFFER_PUSH_PWR_D] = buffer_router_push_pwr_d;
+    energy_dynamic[BUFFER_POP_PWR_D] = buffer_router_pop_pwr_d;
+    energy_dynamic[BUFFER_FRONT_PWR_D] = buffer_router_front_pwr_d;
+    energy_dynamic[BUFFER_TO_TILE_PUSH_PWR_D] = buffer_to_tile_push_pwr_d;
+    energy_dynamic[BUFFER_TO_TILE_POP_PWR_D] = buffer_to_tile_pop_pwr_d;
+    energy_dynamic[BUFFER_TO_TILE_FRONT_PWR_D] = buffer_to_tile_front_pwr_d;
+    energy_dynamic[BUFFER_FROM_TILE_PUSH_PWR_D] = buffer_from_tile_push_pwr_d;
+    energy_dynamic[BUFFER_FROM_TILE_POP_PWR_D] = buffer_from_tile_pop_pwr_d;
+    energy_dynamic[BUFFER_FROM_TILE_FRONT_PWR_D] = buffer_from_tile_front_pwr_d;
+    energy_dynamic[ANTENNA_BUFFER_PUSH_PWR_D] = antenna_buffer_push_pwr_d;
+    energy_dynamic[ANTENNA_BUFFER_POP_PWR_D] = antenna_buffer_pop_pwr_d;
+    energy_dynamic[ANTENNA_BUFFER_FRONT_PWR_D] = antenna_buffer_front_pwr_d;
+    energy_dynamic[ROUTING_PWR_D] = routing_pwr_d;
+    energy_dynamic[SELECTION_PWR_D] = selection_pwr_d;
+    energy_dynamic[CROSSBAR_PWR_D] = crossbar_pwr_d;
+    energy_dynamic[LINK_R2R_PWR_D] = link_r2r_pwr_d;
+    energy_dynamic[LINK_R2H_PWR_D] = link_r2h_pwr_d;
+    energy_dynamic[NI_PWR_D] = ni_pwr_d;
+    energy_dynamic[WIRELESS_TX] = default_tx_energy;
+    energy_dynamic[WIRELESS_DYNAMIC_RX_PWR] = wireless_rx_pwr;
+    energy_dynamic[WIRELESS_SNOOPING] = wireless_snooping;
+
+    energy_static[TRANSCEIVER_RX_PWR_BIASING] = transceiver_rx_pwr_biasing;
+    energy_static[TRANSCEIVER_TX_PWR_BIASING] = transceiver_tx_pwr_biasing;
+    energy_static[BUFFER_ROUTER_PWR_S] = buffer_router_pwr_s;
+    energy_static[BUFFER_TO_TILE_PWR_S] = buffer_to_tile_pwr_s;
+    energy_static[BUFFER_FROM_TILE_PWR_S] = buffer_from_tile_pwr_s;
+    energy_static[ANTENNA_BUFFER_PWR_S] = antenna_buffer_pwr_s;
+    energy_static[LINK_R2H_PWR_S] = link_r2h_pwr_s;
+    energy_static[ROUTING_PWR_S] = routing_pwr_s;
+    energy_static[SELECTION_PWR_S] = selection_pwr_s;
+    energy_static[CROSSBAR_PWR_S] = crossbar_pwr_s;
+    energy_static[NI_PWR_S] = ni_pwr_s;
+    energy_static[TRANSCEIVER_RX_PWR_S] = transceiver_rx_pwr_s;
+    energy_static[TRANSCEIVER_TX_PWR_S] = transceiver_tx_pwr_s;
 }
 
-// Note: In the following 3 functions buffer_pwr_s 
-// is assumed as loaded with the proper values from configuration file:
-// - Router: takes the value of input buffers leakage
-// - Hub: takes the leakage value of buffer_from_tile/to_tile
-void Power::leakageBufferRouter()
-{
-    power_static.breakdown[BUFFER_ROUTER_PWR_S].value +=buffer_router_pwr_s;
-}
 
-void Power::leakageBufferToTile()
+double Power::attenuation2power(double attenuation)
 {
-    power_static.breakdown[BUFFER_TO_TILE_PWR_S].value +=buffer_to_tile_pwr_s;
+    // TODO
+    return attenuation;
 }
 
-void Power::leakageBufferFromTile()
-{
-    power_static.breakdown[BUFFER_FROM_TILE_PWR_S].value +=buffer_from_tile_pwr_s;
-}
 
-// Account for each buffer_rx (Targets) or buffer_tx (Initiators)
-void Power::leakageAntennaBuffer()
-{
-    power_static.breakdown[ANTENNA_BUFFER_PWR_S].value +=(antenna_buffer_pwr_s);
-}
 
-void Power::leakageLinkRouter2Router()
+void Power::wirelessTx(int src,int dst,int length)
 {
-    //power_static.breakdown[LINK_R2R_PWR_S].value +=link_r2r_pwr_s;
-}
+    events_dynamic[WIRELESS_TX]++;
 
-void Power::leakageLinkRouter2Hub()
-{
-    power_static.breakdown[LINK_R2H_PWR_S].value +=link_r2h_pwr_s;
+    // TODO enable attenuation_map: the energy of a transmission would be
+    // attenuation2power(attenuation_map[pair<int,int>(src,dst)]) * length,
+    // so WIRELESS_TX would have to be counted per (src,dst) pair
 }
 
-void Power::leakageRouter()
+void Power::leakageRouter(unsigned long long cycles)
 {
     // note: leakage contributions depending on instance number are 
     // accounted in specific separate leakage functions
-    power_static.breakdown[ROUTING_PWR_S].value +=routing_pwr_s;
-    power_static.breakdown[SELECTION_PWR_S].value +=selection_pwr_s;
-    power_static.breakdown[CROSSBAR_PWR_S].value +=crossbar_pwr_s;
-    power_static.breakdown[NI_PWR_S].value +=ni_pwr_s;
-}
-
-
-
-void Power::leakageTransceiverRx()
-{
-
-    power_static.breakdown[TRANSCEIVER_RX_PWR_S].value +=transceiver_rx_pwr_s;
-}
-
-void Power::leakageTransceiverTx()
-{
-
-    power_static.breakdown[TRANSCEIVER_TX_PWR_S].value +=transceiver_tx_pwr_s;
+    cycles_static[ROUTING_PWR_S] += cycles;
+    cycles_static[SELECTION_PWR_S] += cycles;
+    cycles_static[CROSSBAR_PWR_S] += cycles;
+    cycles_static[NI_PWR_S] += cycles;
 }
 
 void Power::printBreakDown(std::ostream & out)
@@ -466,10 +352,18 @@ void Power::printBreakDown(std::ostream & out)
 }
 
 
+void Power::checkpoint(Checkpoint & cp)
+{
+    cp.transfer(events_dynamic);
+    cp.transfer(cycles_static);
+    cp.transfer(sleep_end_cycle);
+}
+
+
 void Power::rxSleep(int cycles)
 {
 
-    int sleep_start_cycle = (int)(sc_time_stamp().to_double()/GlobalParams::clock_period_ps);
+    int sleep_start_cycle = (int)currentCycle();
     sleep_end_cycle = sleep_start_cycle + cycles;
 }
 
@@ -477,7 +371,7 @@ void Power::rxSleep(int cycles)
 bool Power::isSleeping()
 {
     assert(GlobalParams::use_powermanager);
-    int now = (int)(sc_time_stamp().to_double()/GlobalParams::clock_period_ps);
+    int now = (int)currentCycle();
 
     return (now<sleep_end_cycle);
 
@@ -497,6 +391,11 @@ void Power::initPowerBreakdown()
     power_dynamic.size = NO_BREAKDOWN_ENTRIES_D;
     power_static.size = NO_BREAKDOWN_ENTRIES_S;
 
+    for (int i = 0; i < NO_BREAKDOWN_ENTRIES_D; i++)
+	events_dynamic[i] = 0;
+    for (int i = 0; i < NO_BREAKDOWN_ENTRIES_S; i++)
+	cycles_static[i] = 0;
+
     initPowerBreakdownEntry(&power_dynamic.breakdown[BUFFER_PUSH_PWR_D], "buffer_push_pwr_d");
     initPowerBreakdownEntry(&power_dynamic.breakdown[BUFFER_POP_PWR_D],"buffer_pop_pwr_d");
     initPowerBreakdownEntry(&power_dynamic.breakdown[BUFFER_FRONT_PWR_D],"buffer_front_pwr_d");
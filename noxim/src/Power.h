@@ -21,6 +21,13 @@
 
 using namespace std;
 
+class Checkpoint;
+
+// Power model of a router or a hub. Activity is only counted while
+// simulating: events for the dynamic entries of the breakdown and
+// powered-on unit cycles (one cycle of one buffer, link...) for the
+// static ones. Energy is the counts times the energy of a single event or
+// unit cycle, worked out whenever it is read.
 class Power {
 
   public:
@@ -43,45 +50,51 @@ class Power {
 		      int antenna_buffer_item_size, 
 		      int data_rate_gbs);
 
-    void bufferRouterPush(); 
-    void bufferRouterPop(); 
-    void bufferRouterFront(); 
-    void bufferToTilePush(); 
-    void bufferToTilePop(); 
-    void bufferToTileFront(); 
-    void bufferFromTilePush(); 
-    void bufferFromTilePop(); 
-    void bufferFromTileFront(); 
-    void antennaBufferPush();
-    void antennaBufferPop();
-
-    void antennaBufferFront(); 
+    void bufferRouterPush() { events_dynamic[BUFFER_PUSH_PWR_D]++; }
+    void bufferRouterPop() { events_dynamic[BUFFER_POP_PWR_D]++; }
+    void bufferRouterFront() { events_dynamic[BUFFER_FRONT_PWR_D]++; }
+    void bufferToTilePush() { events_dynamic[BUFFER_TO_TILE_PUSH_PWR_D]++; }
+    void bufferToTilePop() { events_dynamic[BUFFER_TO_TILE_POP_PWR_D]++; }
+    void bufferToTileFront() { events_dynamic[BUFFER_TO_TILE_FRONT_PWR_D]++; }
+    void bufferFromTilePush() { events_dynamic[BUFFER_FROM_TILE_PUSH_PWR_D]++; }
+    void bufferFromTilePop() { events_dynamic[BUFFER_FROM_TILE_POP_PWR_D]++; }
+    void bufferFromTileFront() { events_dynamic[BUFFER_FROM_TILE_FRONT_PWR_D]++; }
+    void antennaBufferPush() { events_dynamic[ANTENNA_BUFFER_PUSH_PWR_D]++; }
+    void antennaBufferPop() { events_dynamic[ANTENNA_BUFFER_POP_PWR_D]++; }
+
+    void antennaBufferFront() { events_dynamic[ANTENNA_BUFFER_FRONT_PWR_D]++; }
     void wirelessTx(int src,int dst,int length);
-    void wirelessDynamicRx();
-    void wirelessSnooping();
-
-    void routing();
-    void selection(); 
-    void crossBar(); 
-    void r2hLink(); 
-    void r2rLink(); 
-    void networkInterface();
-
-    void leakageBufferRouter();
-    void leakageBufferToTile();
-    void leakageBufferFromTile();
-    void leakageAntennaBuffer();
-    void leakageLinkRouter2Router();
-    void leakageLinkRouter2Hub();
-    void leakageRouter();
-    void leakageTransceiverRx();
-    void leakageTransceiverTx();
-    void biasingRx();
-    void biasingTx();
+    void wirelessDynamicRx() { events_dynamic[WIRELESS_DYNAMIC_RX_PWR]++; }
+    void wirelessSnooping() { events_dynamic[WIRELESS_SNOOPING]++; }
+
+    void routing() { events_dynamic[ROUTING_PWR_D]++; }
+    void selection() { events_dynamic[SELECTION_PWR_D]++; }
+    void crossBar() { events_dynamic[CROSSBAR_PWR_D]++; }
+    void r2hLink() { events_dynamic[LINK_R2H_PWR_D]++; }
+    void r2rLink() { events_dynamic[LINK_R2R_PWR_D]++; }
+    void networkInterface() { events_dynamic[NI_PWR_D]++; }
+
+    // Leakage of units instances for one cycle, or of one instance for
+    // units cycles
+    void leakageBufferRouter(unsigned long long units = 1) { cycles_static[BUFFER_ROUTER_PWR_S] += units; }
+    void leakageBufferToTile(unsigned long long units = 1) { cycles_static[BUFFER_TO_TILE_PWR_S] += units; }
+    void leakageBufferFromTile(unsigned long long units = 1) { cycles_static[BUFFER_FROM_TILE_PWR_S] += units; }
+    void leakageAntennaBuffer(unsigned long long units = 1) { cycles_static[ANTENNA_BUFFER_PWR_S] += units; }
+    void leakageLinkRouter2Router(unsigned long long units = 1) { }	// not accounted for
+    void leakageLinkRouter2Hub(unsigned long long units = 1) { cycles_static[LINK_R2H_PWR_S] += units; }
+    void leakageRouter(unsigned long long cycles = 1);
+    void leakageTransceiverRx() { cycles_static[TRANSCEIVER_RX_PWR_S]++; }
+    void leakageTransceiverTx() { cycles_static[TRANSCEIVER_TX_PWR_S]++; }
+    void biasingRx() { cycles_static[TRANSCEIVER_RX_PWR_BIASING]++; }
+    void biasingTx() { cycles_static[TRANSCEIVER_TX_PWR_BIASING]++; }
 
     double getDynamicPower();
     double getStaticPower();
 
+    // Counts behind the dynamic and static entries of the breakdown
+    unsigned long long getDynamicEvents(int entry) const { return events_dynamic[entry]; }
+    unsigned long long getStaticCycles(int entry) const { return cycles_static[entry]; }
+
     double getTotalPower() {
 	return (getDynamicPower() + getStaticPower());
     } 
@@ -90,8 +103,11 @@ class Power {
     void printBreakDown(std::ostream & out);
 
 
-    PowerBreakdown* getDynamicPowerBreakDown(){ return &power_dynamic;}
-    PowerBreakdown* getStaticPowerBreakDown(){ return &power_static;}
+    PowerBreakdown* getDynamicPowerBreakDown();
+    PowerBreakdown* getStaticPowerBreakDown();
+
+    // Saves or restores the activity counted so far
+    void checkpoint(Checkpoint & cp);
 
     void rxSleep(int cycles);
     bool isSleeping();
@@ -155,6 +171,15 @@ class Power {
     PowerBreakdown power_dynamic;
     PowerBreakdown power_static;
 
+    unsigned long long events_dynamic[NO_BREAKDOWN_ENTRIES_D];
+    unsigned long long cycles_static[NO_BREAKDOWN_ENTRIES_S];
+
+    // Energy of one event or unit cycle of each entry, from the values
+    // configured above
+    double energy_dynamic[NO_BREAKDOWN_ENTRIES_D];
+    double energy_static[NO_BREAKDOWN_ENTRIES_S];
+    void setUnitEnergies();
+
     void initPowerBreakdownEntry(PowerBreakdownEntry* pbe,string label);
     void initPowerBreakdown();
 
@@ -9,42 +9,44 @@
  */
 
 #include "ProcessingElement.h"
+#include "Checkpoint.h"
 
 int ProcessingElement::randInt(int min, int max)
 {
-    return min +
-	(int) ((double) (max - min + 1) * rand() / (RAND_MAX + 1.0));
+    return rng.range(min, max);
 }
 
-void ProcessingElement::packet_dec(){
-	while(true){
-		wait();
-		if(dec_queue_in.empty()){
-			continue;
-		}
-		//cout<<"packet reached destination "<<local_id<<endl;
-		Flit flit_tmp = dec_queue_in.front();
-			
-		std::map<string, int>::iterator it;
-		it = enc_lat.find(GlobalParams::exp_type);
-		assert(it != enc_lat.end());
-		wait(it->second);
-		
-		nt_packet_t* nt_pkt = flit_tmp.nt_pkt;
+// Decryption stage: a head flit waits in dec_queue_in for the latency of
+// exp_type before its trace packet is ejected
+void ProcessingElement::decodeStep()
+{
+	if (dec_busy)
+	{
+		if (--dec_countdown > 0)
+			return;
+		nt_packet_t* nt_pkt = dec_queue_in.front().nt_pkt;
 		if (nt_pkt == NULL)
 		{
 			cout<<"Error, this cant be null"<<endl;
 			exit(0);
 		}
-		else
-		{
-			eject_q.push(nt_pkt);
-			//cout<<"Received a packet at destination "<<nt_pkt->id;
-			//cout<<" cycle: "<<sc_time_stamp().to_double() / GlobalParams::clock_period_ps<<endl;
-		}
+		eject_q.push(nt_pkt);
+		//cout<<"Received a packet at destination "<<nt_pkt->id;
+		//cout<<" cycle: "<<sc_time_stamp().to_double() / GlobalParams::clock_period_ps<<endl;
 		dec_queue_in.pop();
-				
+		dec_busy = false;
+		return;
 	}
+	if (dec_queue_in.empty())
+		return;
+	//cout<<"packet reached destination "<<local_id<<endl;
+	std::map<string, int>::iterator it;
+	it = enc_lat.find(GlobalParams::exp_type);
+	assert(it != enc_lat.end());
+	dec_countdown = it->second;
+	dec_busy = true;
+	if (dec_countdown == 0)
+		decodeStep();
 }
 
 void ProcessingElement::rxProcess()
@@ -52,9 +54,13 @@ void ProcessingElement::rxProcess()
     if (reset.read()) {
 	ack_rx.write(0);
 	current_level_rx = 0;
+	dec_busy = false;
     } else {
+	decodeStep();
+
 	if (req_rx.read() == 1 - current_level_rx) {
-	    Flit flit_tmp = flit_rx.read();
+	    FlitHandle handle = flit_rx.read();
+	    const Flit & flit_tmp = FlitPool::get(handle);
 
 	    // netrace interface. Check for the nt_packet pointer and inject it into the eject queue
 	    if (flit_tmp.flit_type == FLIT_TYPE_HEAD)
@@ -62,28 +68,53 @@ void ProcessingElement::rxProcess()
 			dec_queue_in.push(flit_tmp);
 
 	    }
+	    // the flit ends its trip here
+	    FlitPool::release(handle);
 	    current_level_rx = 1 - current_level_rx;	// Negate the old value for Alternating Bit Protocol (ABP)
 	}
 	ack_rx.write(current_level_rx);
     }
 }
 
-void ProcessingElement::packet_enc(){
-	
-	while(true){
-		wait();
-		if(enc_queue_in.empty()){
-			continue;
-		}
-		Packet packet = enc_queue_in.front();
-			
-		std::map<string, int>::iterator it;
-		it = enc_lat.find(GlobalParams::exp_type);
-		assert(it != enc_lat.end());
-		wait(it->second);
-		packet_queue.push(packet);
+// Encryption stage: a packet waits in enc_queue_in for the latency of
+// exp_type before it is queued for transmission
+void ProcessingElement::encodeStep()
+{
+	if (enc_busy)
+	{
+		if (--enc_countdown > 0)
+			return;
+		packet_queue.push(enc_queue_in.front());
 		enc_queue_in.pop();
+		enc_busy = false;
+		return;
 	}
+	if (enc_queue_in.empty())
+		return;
+	std::map<string, int>::iterator it;
+	it = enc_lat.find(GlobalParams::exp_type);
+	assert(it != enc_lat.end());
+	enc_countdown = it->second;
+	enc_busy = true;
+	if (enc_countdown == 0)
+		encodeStep();
+}
+
+void ProcessingElement::checkpoint(Checkpoint & cp)
+{
+    cp.transfer(current_level_rx);
+    cp.transfer(current_level_tx);
+    cp.transfer(transmittedAtPreviousCycle);
+    cp.transfer(packet_queue);
+    cp.transfer(enc_queue_in);
+    cp.transfer(enc_busy);
+    cp.transfer(enc_countdown);
+    cp.transfer(dec_queue_in);
+    cp.transfer(dec_busy);
+    cp.transfer(dec_countdown);
+    cp.transfer(inject_q);
+    cp.transfer(eject_q);
+    rng.checkpoint(cp);
 }
 
 void ProcessingElement::txProcess()
@@ -92,8 +123,19 @@ void ProcessingElement::txProcess()
 	req_tx.write(0);
 	current_level_tx = 0;
 	transmittedAtPreviousCycle = false;
+	enc_busy = false;
     } else {
 	Packet packet;
+
+	encodeStep();
+
+	// a PE with no trace packet anywhere in its pipeline has nothing to
+	// draw or send (synthetic traffic draws random numbers every cycle)
+	if (GlobalParams::traffic_distribution == TRAFFIC_NETRACE &&
+	    inject_q.is_empty() && enc_queue_in.empty() && packet_queue.empty()) {
+	    transmittedAtPreviousCycle = false;
+	    return;
+	}
 	
 	
 
@@ -101,6 +143,10 @@ void ProcessingElement::txProcess()
 		// netrace interface
 		if (packet.nt_pkt != nullptr)
 		  enc_queue_in.push(packet);
+		// trace packets due in the same cycle are issued back-to-back
+		if (GlobalParams::traffic_distribution == TRAFFIC_NETRACE)
+		  while (canShot(packet))
+		    enc_queue_in.push(packet);
 			
 	    transmittedAtPreviousCycle = true;
 	} else
@@ -109,7 +155,7 @@ void ProcessingElement::txProcess()
 
 	if (ack_tx.read() == current_level_tx) {
 	    if (!packet_queue.empty()) {
-		Flit flit = nextFlit();	// Generate a new flit
+		FlitHandle flit = nextFlit();	// Generate a new flit
 		flit_tx->write(flit);	// Send the generated flit
 		current_level_tx = 1 - current_level_tx;	// Negate the old value for Alternating Bit Protocol (ABP)
 		req_tx.write(current_level_tx);
@@ -118,7 +164,7 @@ void ProcessingElement::txProcess()
     }
 }
 
-Flit ProcessingElement::nextFlit()
+FlitHandle ProcessingElement::nextFlit()
 {
     Flit flit;
     Packet packet = packet_queue.front();
@@ -146,13 +192,13 @@ Flit ProcessingElement::nextFlit()
     if (packet_queue.front().flit_left == 0)
 	packet_queue.pop();
 
-    return flit;
+    return FlitPool::alloc(flit);
 }
 
 bool ProcessingElement::canShot(Packet & packet)
 {
     /* DEADLOCK TEST 
-	double current_time = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+	double current_time = currentCycle();
 
 	if (current_time >= 4100) 
 	{
@@ -169,7 +215,13 @@ bool ProcessingElement::canShot(Packet & packet)
     bool shot;
     double threshold;
 
-    double now = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+    // trace packets follow the trace timestamps, not the injection rate
+    if (GlobalParams::traffic_distribution == TRAFFIC_NETRACE) {
+	packet = traffic_netrace();
+	return packet.nt_pkt != nullptr;
+    }
+
+    long long now = currentCycle();
 
     if (GlobalParams::traffic_distribution != TRAFFIC_TABLE_BASED) {
 	if (!transmittedAtPreviousCycle)
@@ -177,7 +229,7 @@ bool ProcessingElement::canShot(Packet & packet)
 	else
 	    threshold = GlobalParams::probability_of_retransmission;
 
-	shot = (((double) rand()) / RAND_MAX < threshold);
+	shot = (rng.uniform() < threshold);
 	if (shot) {
 	    if (GlobalParams::traffic_distribution == TRAFFIC_RANDOM)
 		    packet = trafficRandom();
@@ -195,8 +247,6 @@ bool ProcessingElement::canShot(Packet & packet)
 		    packet = trafficLocal();
         else if (GlobalParams::traffic_distribution == TRAFFIC_ULOCAL)
 		    packet = trafficULocal();
-        else if (GlobalParams::traffic_distribution == TRAFFIC_NETRACE)
-		    packet = traffic_netrace();
         else
 		    assert(false);
 	}
@@ -205,18 +255,18 @@ bool ProcessingElement::canShot(Packet & packet)
 	    return false;
 
 	bool use_pir = (transmittedAtPreviousCycle == false);
-	vector < pair < int, double > > dst_prob;
+	const vector < pair < int, double > > * dst_prob;
 	double threshold =
 	    traffic_table->getCumulativePirPor(local_id, (int) now,
 					       use_pir, dst_prob);
 
-	double prob = (double) rand() / RAND_MAX;
+	double prob = rng.uniform();
 	shot = (prob < threshold);
 	if (shot) {
-	    for (unsigned int i = 0; i < dst_prob.size(); i++) {
-		if (prob < dst_prob[i].second) {
+	    for (unsigned int i = 0; i < dst_prob->size(); i++) {
+		if (prob < (*dst_prob)[i].second) {
                     int vc = randInt(0,GlobalParams::n_virtual_channels-1);
-		    packet.make(local_id, dst_prob[i].first, vc, now, getRandomSize());
+		    packet.make(local_id, (*dst_prob)[i].first, vc, now, getRandomSize());
 		    break;
 		}
 	    }
@@ -231,7 +281,7 @@ Packet ProcessingElement::trafficLocal()
 {
     Packet p;
     p.src_id = local_id;
-    double rnd = rand() / (double) RAND_MAX;
+    double rnd = rng.uniform();
 
     vector<int> dst_set;
 
@@ -250,10 +300,10 @@ Packet ProcessingElement::trafficLocal()
     }
 
 
-    int i_rnd = rand()%dst_set.size();
+    int i_rnd = rng.below(dst_set.size());
 
     p.dst_id = dst_set[i_rnd];
-    p.timestamp = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+    p.timestamp = currentCycle();
     p.size = p.flit_left = getRandomSize();
 
     return p;
@@ -263,8 +313,8 @@ Packet ProcessingElement::trafficLocal()
 
 int ProcessingElement::findRandomDestination(int id, int hops)
 {
-    int inc_y = rand()%2?-1:1;
-    int inc_x = rand()%2?-1:1;
+    int inc_y = rng.below(2)?-1:1;
+    int inc_x = rng.below(2)?-1:1;
     
     Coord current =  id2Coord(id);
     
@@ -285,7 +335,7 @@ int ProcessingElement::findRandomDestination(int id, int hops)
 	if (current.y==GlobalParams::mesh_dim_y-1)
 	    if (inc_y>0) inc_y=0;
 
-	if (rand()%2)
+	if (rng.below(2))
 	    current.x +=inc_x;
 	else
 	    current.y +=inc_y;
@@ -294,12 +344,12 @@ int ProcessingElement::findRandomDestination(int id, int hops)
 }
 
 
-int roulette()
+int roulette(RandomStream & rng)
 {
     int slices = GlobalParams::mesh_dim_x + GlobalParams::mesh_dim_y -2;
 
 
-    double r = rand()/(double)RAND_MAX;
+    double r = rng.uniform();
 
 
     for (int i=1;i<=slices;i++)
@@ -319,11 +369,11 @@ Packet ProcessingElement::trafficULocal()
     Packet p;
     p.src_id = local_id;
 
-    int target_hops = roulette();
+    int target_hops = roulette(rng);
 
     p.dst_id = findRandomDestination(local_id,target_hops);
 
-    p.timestamp = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+    p.timestamp = currentCycle();
     p.size = p.flit_left = getRandomSize();
 
     return p;
@@ -333,7 +383,7 @@ Packet ProcessingElement::trafficRandom()
 {
     Packet p;
     p.src_id = local_id;
-    double rnd = rand() / (double) RAND_MAX;
+    double rnd = rng.uniform();
     double range_start = 0.0;
 
     int max_id = (GlobalParams::mesh_dim_x * GlobalParams::mesh_dim_y) - 1;
@@ -362,7 +412,7 @@ Packet ProcessingElement::trafficRandom()
 
     } while (p.dst_id == p.src_id);
 
-    p.timestamp = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+    p.timestamp = currentCycle();
     p.size = p.flit_left = getRandomSize();
     p.vc_id = randInt(0,GlobalParams::n_virtual_channels-1);
 
@@ -376,7 +426,7 @@ Packet ProcessingElement::trafficTest()
     p.src_id = local_id;
     p.dst_id = 10;
 
-    p.timestamp = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+    p.timestamp = currentCycle();
     p.size = p.flit_left = getRandomSize();
     p.vc_id = randInt(0,GlobalParams::n_virtual_channels-1);
 
@@ -398,7 +448,7 @@ Packet ProcessingElement::trafficTranspose1()
     p.dst_id = coord2Id(dst);
 
     p.vc_id = randInt(0,GlobalParams::n_virtual_channels-1);
-    p.timestamp = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+    p.timestamp = currentCycle();
     p.size = p.flit_left = getRandomSize();
 
     return p;
@@ -419,7 +469,7 @@ Packet ProcessingElement::trafficTranspose2()
     p.dst_id = coord2Id(dst);
 
     p.vc_id = randInt(0,GlobalParams::n_virtual_channels-1);
-    p.timestamp = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+    p.timestamp = currentCycle();
     p.size = p.flit_left = getRandomSize();
 
     return p;
@@ -439,7 +489,7 @@ Packet ProcessingElement::traffic_netrace()
     	return p;
     	//exit(0);
     }
-    else if(nt_pkt->cycle > (sc_time_stamp().to_double() / GlobalParams::clock_period_ps) )
+    else if((long long) nt_pkt->cycle > currentCycle() + trace_cycle_offset)
     {
     	p.make(0,0,0,0,0);  //represents an empty packet
     	//exit(0);
@@ -456,7 +506,7 @@ Packet ProcessingElement::traffic_netrace()
 		p.nt_pkt = nt_pkt;
 
 		p.vc_id = randInt(0,GlobalParams::n_virtual_channels-1);
-		p.timestamp = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+		p.timestamp = currentCycle();
 		p.size = p.flit_left = getRandomSize();
 
 		inject_q.pop();
@@ -503,7 +553,7 @@ Packet ProcessingElement::trafficBitReversal()
     p.src_id = local_id;
     p.dst_id = dnode;
 
-    p.timestamp = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+    p.timestamp = currentCycle();
     p.size = p.flit_left = getRandomSize();
 
     return p;
@@ -527,7 +577,7 @@ Packet ProcessingElement::trafficShuffle()
     p.dst_id = dnode;
 
     p.vc_id = randInt(0,GlobalParams::n_virtual_channels-1);
-    p.timestamp = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+    p.timestamp = currentCycle();
     p.size = p.flit_left = getRandomSize();
 
     return p;
@@ -552,7 +602,7 @@ Packet ProcessingElement::trafficButterfly()
     p.dst_id = dnode;
 
     p.vc_id = randInt(0,GlobalParams::n_virtual_channels-1);
-    p.timestamp = sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+    p.timestamp = currentCycle();
     p.size = p.flit_left = getRandomSize();
 
     return p;
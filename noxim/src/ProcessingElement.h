@@ -16,12 +16,16 @@
 #include <string>
 
 #include "DataStructs.h"
+#include "FlitPool.h"
 #include "GlobalTrafficTable.h"
 #include "Utils.h"
 #include "nqueue.h"
+#include "RandomStream.h"
 
 using namespace std;
 
+class Checkpoint;
+
 SC_MODULE(ProcessingElement)
 {
 
@@ -29,12 +33,12 @@ SC_MODULE(ProcessingElement)
     sc_in_clk clock;		// The input clock for the PE
     sc_in < bool > reset;	// The reset signal for the PE
 
-    sc_in < Flit > flit_rx;	// The input channel
+    sc_in < FlitHandle > flit_rx;	// The input channel
     sc_in < bool > req_rx;	// The request associated with the input channel
     sc_out < bool > ack_rx;	// The outgoing ack signal associated with the input channel
     sc_out < TBufferFullStatus > buffer_full_status_rx;	
 
-    sc_out < Flit > flit_tx;	// The output channel
+    sc_out < FlitHandle > flit_tx;	// The output channel
     sc_out < bool > req_tx;	// The request associated with the output channel
     sc_in < bool > ack_tx;	// The outgoing ack signal associated with the output channel
     sc_in < TBufferFullStatus > buffer_full_status_tx;
@@ -48,18 +52,24 @@ SC_MODULE(ProcessingElement)
     queue < Packet > packet_queue;	// Local queue of packets
     
     bool transmittedAtPreviousCycle;	// Used for distributions with memory
+    RandomStream rng;		// Random numbers of this PE
     // yash changes
     queue <Packet> enc_queue_in;
     queue <Flit> dec_queue_in;
     std::map<string, int> enc_lat;
+    bool enc_busy;		// front of enc_queue_in is being encrypted
+    int enc_countdown;		// cycles left for it
+    bool dec_busy;		// front of dec_queue_in is being decrypted
+    int dec_countdown;
 
     // Functions
     void rxProcess();		// The receiving process
     void txProcess();		// The transmitting process
-    void packet_enc();
-    void packet_dec();
+    void encodeStep();		// One cycle of the encryption stage
+    void decodeStep();		// One cycle of the decryption stage
+    void checkpoint(Checkpoint & cp);	// Saves or restores queues and protocol state
     bool canShot(Packet & packet);	// True when the packet must be shot
-    Flit nextFlit();	// Take the next flit of the current packet
+    FlitHandle nextFlit();	// Take the next flit of the current packet
     Packet trafficTest();	// used for testing traffic
     Packet trafficRandom();	// Random destination distribution
     Packet trafficTranspose1();	// Transpose 1 destination distribution
@@ -102,16 +112,20 @@ SC_MODULE(ProcessingElement)
 		enc_lat.insert(std::pair<string, int>("base", 0));
 		
 		
-	SC_METHOD(rxProcess);
-	sensitive << reset;
-	sensitive << clock.pos();
-
-	SC_METHOD(txProcess);
-	sensitive << reset;
-	sensitive << clock.pos();
-
-        SC_CTHREAD(packet_enc, clock.pos());
-        SC_CTHREAD(packet_dec, clock.pos());
+	enc_busy = false;
+	dec_busy = false;
+
+	// with the flat engine NoC::evaluate() calls the processes
+	if (!GlobalParams::flat_engine)
+	{
+	    SC_METHOD(rxProcess);
+	    sensitive << reset;
+	    sensitive << clock.pos();
+
+	    SC_METHOD(txProcess);
+	    sensitive << reset;
+	    sensitive << clock.pos();
+	}
     }
 
 };
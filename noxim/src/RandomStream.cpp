@@ -0,0 +1,69 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the implementation of the random number streams
+ */
+
+#include "RandomStream.h"
+#include "Checkpoint.h"
+
+#define PHILOX_M0	0xD2511F53u
+#define PHILOX_M1	0xCD9E8D57u
+#define PHILOX_W0	0x9E3779B9u
+#define PHILOX_W1	0xBB67AE85u
+#define PHILOX_ROUNDS	10
+
+RandomStream::RandomStream()
+{
+    seed(0, 0, 0);
+}
+
+void RandomStream::seed(const unsigned int seed, const int kind, const int id)
+{
+    key[0] = seed;
+    key[1] = ((uint32_t) kind << 24) ^ (uint32_t) id;
+    counter = 0;
+}
+
+void RandomStream::seek(const uint64_t n)
+{
+    counter = n;
+    // next() only generates at block boundaries
+    if ((counter & 3) != 0)
+	generate();
+}
+
+void RandomStream::generate()
+{
+    uint64_t index = counter >> 2;
+    uint32_t c[4] = { (uint32_t) index, (uint32_t) (index >> 32), 0, 0 };
+    uint32_t k0 = key[0], k1 = key[1];
+
+    for (int round = 0; round < PHILOX_ROUNDS; round++) {
+	uint64_t p0 = (uint64_t) PHILOX_M0 * c[0];
+	uint64_t p1 = (uint64_t) PHILOX_M1 * c[2];
+	uint32_t c1 = c[1], c3 = c[3];
+
+	c[0] = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+	c[1] = (uint32_t) p1;
+	c[2] = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+	c[3] = (uint32_t) p0;
+	k0 += PHILOX_W0;
+	k1 += PHILOX_W1;
+    }
+
+    for (int i = 0; i < 4; i++)
+	block[i] = c[i];
+}
+
+void RandomStream::checkpoint(Checkpoint & cp)
+{
+    cp.transfer(key);
+    cp.transfer(counter);
+    if (!cp.isSaving())
+	seek(counter);
+}
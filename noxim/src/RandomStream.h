@@ -0,0 +1,74 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the declaration of the random number streams
+ */
+
+#ifndef __NOXIMRANDOMSTREAM_H__
+#define __NOXIMRANDOMSTREAM_H__
+
+#include <cassert>
+#include <stdint.h>
+
+class Checkpoint;
+
+// Kinds of component owning a stream, part of the stream key
+#define RANDOM_STREAM_PE	1
+#define RANDOM_STREAM_ROUTER	2
+#define RANDOM_STREAM_HUB	3
+
+// Counter-based random numbers (Philox4x32-10). Draw n of a stream is a
+// function of its key and n alone: every PE, router and hub owns a stream
+// keyed by the seed and its id, so the numbers it gets depend neither on
+// the order components are evaluated in nor on the other components.
+class RandomStream {
+
+  public:
+
+    RandomStream();
+
+    // Restarts the stream of component id of the given kind
+    void seed(const unsigned int seed, const int kind, const int id);
+
+    // Moves to draw n of the stream
+    void seek(const uint64_t n);
+
+    // Uniform 32 bit integer
+    inline uint32_t next() {
+	if ((counter & 3) == 0)
+	    generate();
+	return block[counter++ & 3];
+    }
+
+    // Uniform in [0, n)
+    inline unsigned int below(const unsigned int n) {
+	assert(n > 0);
+	return (unsigned int) (((uint64_t) next() * n) >> 32);
+    }
+
+    // Uniform in [min, max]
+    inline int range(const int min, const int max) {
+	return min + (int) below((unsigned int) (max - min + 1));
+    }
+
+    // Uniform in [0, 1)
+    inline double uniform() {
+	return next() * (1.0 / 4294967296.0);
+    }
+
+    void checkpoint(Checkpoint & cp);
+
+  private:
+
+    void generate();			// block = Philox(key, counter / 4)
+
+    uint32_t key[2];
+    uint64_t counter;			// Draws so far
+    uint32_t block[4];
+};
+
+#endif
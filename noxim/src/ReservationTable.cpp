@@ -9,9 +9,13 @@
  */
 
 #include "ReservationTable.h"
+#include "Checkpoint.h"
 
 ReservationTable::ReservationTable()
 {
+    rtable = NULL;
+    n_outputs = 0;
+    n_reservations = 0;
 }
 
 void ReservationTable::setSize(const int n_outputs)
@@ -21,65 +25,75 @@ void ReservationTable::setSize(const int n_outputs)
 
     for (int i=0;i<n_outputs;i++)
     {
+	rtable[i].size = 0;
 	rtable[i].index = 0;
-	rtable[i].reservations.clear();
+	rtable[i].vc_mask = 0;
+	for (int vc=0;vc<MAX_VIRTUAL_CHANNELS;vc++)
+	    rtable[i].vc_input[vc] = NOT_RESERVED;
     }
+    n_reservations = 0;
+    reserved_output.clear();
+    found.reserve(n_outputs);
+}
+
+int & ReservationTable::reservedOutput(const TReservation r)
+{
+    unsigned int slot = r.input * MAX_VIRTUAL_CHANNELS + r.vc;
+
+    if (slot >= reserved_output.size())
+	reserved_output.resize(slot + MAX_VIRTUAL_CHANNELS, NOT_RESERVED);
+    return reserved_output[slot];
 }
 
 bool ReservationTable::isNotReserved(const int port_out)
 {
     assert(port_out<n_outputs);
-    return (rtable[port_out].reservations.size()==0);
+    return (rtable[port_out].size==0);
 }
 
 /* For a given input, returns the set of output/vc reserved from that input.
  * An index is required for each output entry, to avoid that multiple invokations
  * with different inputs returns the same output in the same clock cycle. */
-vector<pair<int,int> > ReservationTable::getReservations(const int port_in)
+const vector<pair<int,int> > & ReservationTable::getReservations(const int port_in)
 {
-    vector<pair<int,int> > reservations;
+    found.clear();
+
+    if (n_reservations == 0)
+	return found;
 
     for (int o = 0;o<n_outputs;o++)
     {
-	if (rtable[o].reservations.size()>0)
+	if (rtable[o].size>0)
 	{
-	    int current_index = rtable[o].index;
-	    if (rtable[o].reservations[current_index].input == port_in)
-		reservations.push_back(pair<int,int>(o,rtable[o].reservations[current_index].vc));
+	    const TReservation & current = rtable[o].reservations[rtable[o].index];
+	    if (current.input == port_in)
+		found.push_back(pair<int,int>(o,current.vc));
 	}
     }
-    return reservations;
+    return found;
 }
 
 int ReservationTable::checkReservation(const TReservation r, const int port_out)
 {
     /* Sanity Check for forbidden table status:
      * - same input/VC in a different output line */
-    for (int o=0;o<n_outputs;o++)
-    {
-	for (int i=0;i<rtable[o].reservations.size(); i++)
-	{
-	    // In the current implementation this should never happen
-	    if (o!=port_out && rtable[o].reservations[i] == r)
-	    {
-		return RT_ALREADY_OTHER_OUT;
-	    }
-	}
-    }
-    
+    int reserved = getReservedOutput(r);
+
+    // In the current implementation this should never happen
+    if (reserved != NOT_RESERVED && reserved != port_out)
+	return RT_ALREADY_OTHER_OUT;
+
      /* On a given output entry, reservations must differ by VC
      *  Motivation: they will be interleaved cycle-by-cycle as index moves */
 
-    for (int i=0;i<rtable[port_out].reservations.size(); i++)
+    if (rtable[port_out].vc_mask & (1u << r.vc))
     {
 	// the reservation is already present
-	if (rtable[port_out].reservations[i] == r)
+	if (rtable[port_out].vc_input[r.vc] == r.input)
 	    return RT_ALREADY_SAME;
 
 	// the same VC for that output has been reserved by another input
-	if (rtable[port_out].reservations[i].input != r.input &&
-	    rtable[port_out].reservations[i].vc == r.vc)
-	    return RT_OUTVC_BUSY;
+	return RT_OUTVC_BUSY;
     }
     return RT_AVAILABLE;
 }
@@ -89,7 +103,7 @@ void ReservationTable::print()
     for (int o=0;o<n_outputs;o++)
     {
 	cout << o << ": ";
-	for (int i=0;i<rtable[o].reservations.size();i++)
+	for (int i=0;i<rtable[o].size;i++)
 	{
 	    cout << "<" << rtable[o].reservations[i].input << "," << rtable[o].reservations[i].vc << ">, ";
 	}
@@ -99,6 +113,18 @@ void ReservationTable::print()
 }
 
 
+void ReservationTable::add(const TReservation r, const int port_out)
+{
+    TRTEntry & entry = rtable[port_out];
+
+    assert(entry.size < MAX_VIRTUAL_CHANNELS);
+    entry.reservations[entry.size++] = r;
+    entry.vc_mask |= 1u << r.vc;
+    entry.vc_input[r.vc] = r.input;
+    reservedOutput(r) = port_out;
+    n_reservations++;
+}
+
 void ReservationTable::reserve(const TReservation r, const int port_out)
 {
     // IMPORTANT: problem when used by Hub with more connections
@@ -109,41 +135,63 @@ void ReservationTable::reserve(const TReservation r, const int port_out)
 
     // TODO: a better policy could insert in a specific position as far a possible
     // from the current index
-    rtable[port_out].reservations.push_back(r);
-
+    add(r, port_out);
 }
 
 void ReservationTable::release(const TReservation r, const int port_out)
 {
     assert(port_out < n_outputs);
 
-    for (vector<TReservation>::iterator i=rtable[port_out].reservations.begin(); 
-	    i != rtable[port_out].reservations.end(); i++)
-    {
-	if (*i == r)
-	{
-	    rtable[port_out].reservations.erase(i);
-	    int removed_index = i - rtable[port_out].reservations.begin();
+    TRTEntry & entry = rtable[port_out];
+
+    //trying to release a never made reservation  ?
+    assert((entry.vc_mask & (1u << r.vc)) && entry.vc_input[r.vc] == r.input);
+
+    // keep the order of the others, the index walks through it
+    int removed_index = 0;
+    while (!(entry.reservations[removed_index] == r))
+	removed_index++;
+    for (int i = removed_index; i < entry.size - 1; i++)
+	entry.reservations[i] = entry.reservations[i + 1];
+    entry.size--;
+
+    entry.vc_mask &= ~(1u << r.vc);
+    entry.vc_input[r.vc] = NOT_RESERVED;
+    reservedOutput(r) = NOT_RESERVED;
+    n_reservations--;
+
+    if (removed_index < entry.index)
+	entry.index--;
+    else
+	if (entry.index >= entry.size)
+	    entry.index = 0;
+}
 
-	    if (removed_index < rtable[port_out].index)
-		rtable[port_out].index--;
-	    else
-		if (rtable[port_out].index >= rtable[port_out].reservations.size())
-		    rtable[port_out].index = 0;
+void ReservationTable::updateIndex()
+{
+    if (n_reservations == 0)
+	return;
 
-	    return;
-	}
+    for (int o=0;o<n_outputs;o++)
+    {
+	if (rtable[o].size>0)
+	    rtable[o].index = (rtable[o].index+1)%(rtable[o].size);
     }
-    assert(false); //trying to release a never made reservation  ?
 }
 
-void ReservationTable::updateIndex()
+void ReservationTable::checkpoint(Checkpoint & cp)
 {
     for (int o=0;o<n_outputs;o++)
     {
-	if (rtable[o].reservations.size()>0)
-	    rtable[o].index = (rtable[o].index+1)%(rtable[o].reservations.size());
+	vector<TReservation> reservations(rtable[o].reservations, rtable[o].reservations + rtable[o].size);
+	cp.transfer(reservations);
+	if (!cp.isSaving())
+	{
+	    while (rtable[o].size > 0)
+		release(rtable[o].reservations[0], o);
+	    for (unsigned int i = 0; i < reservations.size(); i++)
+		add(reservations[i], o);
+	}
+	cp.transfer(rtable[o].index);
     }
 }
-
-
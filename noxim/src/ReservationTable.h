@@ -17,6 +17,8 @@
 
 using namespace std;
 
+class Checkpoint;
+
 
 struct TReservation
 {
@@ -28,10 +30,16 @@ struct TReservation
     }
 };
 
+// Reservations of an output, in the order they were made. They differ by
+// VC, so there are at most MAX_VIRTUAL_CHANNELS of them: vc_mask has a bit
+// per reserved VC and vc_input tells which input holds it.
 typedef struct RTEntry
 {
-    vector<TReservation> reservations;
+    TReservation reservations[MAX_VIRTUAL_CHANNELS];
+    int size;
     int index;
+    unsigned int vc_mask;
+    int vc_input[MAX_VIRTUAL_CHANNELS];
 } TRTEntry;
 
 class ReservationTable {
@@ -51,8 +59,15 @@ class ReservationTable {
     // Asserts if port_out is not reserved or not valid
     void release(const TReservation r, const int port_out);
 
-    // Returns the pairs of output port and virtual channel reserved by port_in
-    vector<pair<int,int> > getReservations(const int port_int);
+    // Returns the pairs of output port and virtual channel reserved by
+    // port_in. The result is overwritten by the next call.
+    const vector<pair<int,int> > & getReservations(const int port_int);
+
+    // Returns the output reserved by input/VC r, or NOT_RESERVED
+    int getReservedOutput(const TReservation r) const {
+	unsigned int slot = r.input * MAX_VIRTUAL_CHANNELS + r.vc;
+	return slot < reserved_output.size() ? reserved_output[slot] : NOT_RESERVED;
+    }
 
     // update the index of the reservation having highest priority in the current cycle
     void updateIndex();
@@ -60,8 +75,16 @@ class ReservationTable {
     // check whether port_out has no reservations
     bool isNotReserved(const int port_out);
 
+    // check whether no output is reserved at all
+    bool isEmpty() const {
+	return n_reservations == 0;
+    }
+
     void setSize(const int n_outputs);
 
+    // Save or restore the reservations
+    void checkpoint(Checkpoint & cp);
+
     void print();
 
   private:
@@ -70,6 +93,16 @@ class ReservationTable {
 			// which reserved output port
 
      int n_outputs;
+     int n_reservations;
+
+     // reverse map: output reserved by input/VC, or NOT_RESERVED. Inputs
+     // are not known in advance (hubs use channel ids), it grows on demand.
+     vector<int> reserved_output;
+
+     vector<pair<int,int> > found;	// result of getReservations()
+
+     int & reservedOutput(const TReservation r);
+     void add(const TReservation r, const int port_out);
 };
 
 #endif
@@ -9,13 +9,45 @@
  */
 
 #include "Router.h"
+#include "Checkpoint.h"
 
 void Router::process()
 {
+    // with nothing to move, txProcess() and rxProcess() would only
+    // rotate the arbitration pointers and rewrite unchanged outputs
+    if (!reset.read() && isIdle()) {
+	idle_cycles++;
+	return;
+    }
+    catchUp();
     txProcess();
     rxProcess();
 }
 
+bool Router::isIdle()
+{
+    if (buffered_flits > 0 || !reservation_table.isEmpty())
+	return false;
+
+    for (int i = 0; i < DIRECTIONS + 2; i++)
+	if (req_rx[i].read() == 1 - current_level_rx[i])
+	    return false;
+
+    return true;
+}
+
+void Router::catchUp()
+{
+    if (idle_cycles == 0)
+	return;
+
+    start_from_port = (start_from_port + idle_cycles) % (DIRECTIONS + 2);
+    for (int i = 0; i < DIRECTIONS + 2; i++)
+	start_from_vc[i] = (start_from_vc[i] + idle_cycles) % GlobalParams::n_virtual_channels;
+    // updateIndex() has no effect without reservations
+    idle_cycles = 0;
+}
+
 void Router::rxProcess()
 {
     if (reset.read()) {
@@ -41,13 +73,15 @@ void Router::rxProcess()
 
 	    if (req_rx[i].read() == 1 - current_level_rx[i])
 	    {
-		Flit received_flit = flit_rx[i].read();
+		FlitHandle received_handle = flit_rx[i].read();
+		const Flit & received_flit = FlitPool::get(received_handle);
 		int vc = received_flit.vc_id;
 
 		if (!buffer[i][vc].IsFull()) 
 		{
 		    // Store the incoming flit in the circular buffer
-		    buffer[i][vc].Push(received_flit);
+		    buffer[i][vc].Push(received_handle);
+		    buffered_flits++;
 
 		    LOG << " Flit " << received_flit << " collected from Input[" << i << "][" << vc <<"]" << endl;
 
@@ -106,11 +140,24 @@ void Router::txProcess()
 
 	      if (!buffer[i][vc].IsEmpty()) 
 	      {
-		  Flit flit = buffer[i][vc].Front();
+		  const Flit & flit = FlitPool::get(buffer[i][vc].Front());
 		  power.bufferRouterFront();
 
 		  if (flit.flit_type == FLIT_TYPE_HEAD) 
 		    {
+		      TReservation r;
+		      r.input = i;
+		      r.vc = vc;
+
+		      // A head flit is routed once: the output it reserved stays
+		      // its route until the tail flit releases it
+		      int reserved = reservation_table.getReservedOutput(r);
+		      if (reserved != NOT_RESERVED)
+		      {
+			  LOG << " RT_ALREADY_SAME reserved direction " << reserved << " for flit " << flit << endl;
+			  continue;
+		      }
+
 		      // prepare data for routing
 		      RouteData route_data;
 		      route_data.current_id = local_id;
@@ -119,13 +166,8 @@ void Router::txProcess()
 		      route_data.dir_in = i;
 		      route_data.vc_id = flit.vc_id;
 
-		      // TODO: see PER POSTERI (adaptive routing should not recompute route if already reserved)
 		      int o = route(route_data);
 
-		      TReservation r;
-		      r.input = i;
-		      r.vc = vc;
-
 		      LOG << " checking reservation availability of Output " << o << " Input[" << i << "][" << vc << "] for flit " << flit << endl;
 
 		      int rt_status = reservation_table.checkReservation(r,o);
@@ -159,11 +201,11 @@ void Router::txProcess()
       // 2nd phase: Forwarding
       for (int i = 0; i < DIRECTIONS + 2; i++) 
       {
-	  vector<pair<int,int> > reservations = reservation_table.getReservations(i);
+	  const vector<pair<int,int> > & reservations = reservation_table.getReservations(i);
 	  
 	  if (reservations.size()!=0)
 	  {
-	      int rnd_idx = rand()%reservations.size();
+	      int rnd_idx = rng.below(reservations.size());
 
 	      int o = reservations[rnd_idx].first;
 	      int vc = reservations[rnd_idx].second;
@@ -172,7 +214,8 @@ void Router::txProcess()
 	      if (!buffer[i][vc].IsEmpty())  
 	      {
 		  // power contribution already computed in 1st phase
-		  Flit flit = buffer[i][vc].Front();
+		  FlitHandle handle = buffer[i][vc].Front();
+		  const Flit & flit = FlitPool::get(handle);
 
 		  if ( (current_level_tx[o] == ack_tx[o].read()) &&
 		       (buffer_full_status_tx[o].read().mask[vc] == false) ) 
@@ -180,10 +223,11 @@ void Router::txProcess()
 		      //if (GlobalParams::verbose_mode > VERBOSE_OFF) 
 		      LOG << "Input[" << i << "][" << vc << "] forwarded to Output[" << o << "], flit: " << flit << endl;
 
-		      flit_tx[o].write(flit);
+		      flit_tx[o].write(handle);
 		      current_level_tx[o] = 1 - current_level_tx[o];
 		      req_tx[o].write(current_level_tx[o]);
 		      buffer[i][vc].Pop();
+		      buffered_flits--;
 
 		      if (flit.flit_type == FLIT_TYPE_TAIL)
 		      {
@@ -205,7 +249,7 @@ void Router::txProcess()
 		      {
 			  power.networkInterface();
 			  LOG << "Consumed flit " << flit << endl;
-			  stats.receivedFlit(sc_time_stamp().to_double() / GlobalParams::clock_period_ps, flit);
+			  stats.receivedFlit(currentCycle(), flit);
 			  if (GlobalParams:: max_volume_to_be_drained) 
 			  {
 			      if (drained_volume >= GlobalParams:: max_volume_to_be_drained)
@@ -233,7 +277,7 @@ void Router::txProcess()
 	  } // if not reserved
       } // for loop directions
 
-      if ((int)(sc_time_stamp().to_double() / GlobalParams::clock_period_ps)%2==0)
+      if ((int)currentCycle()%2==0)
 	  reservation_table.updateIndex();
     }   
 }
@@ -267,21 +311,86 @@ void Router::perCycleUpdate()
     } else {
         selectionStrategy->perCycleUpdate(this);
 
-	power.leakageRouter();
-	for (int i = 0; i < DIRECTIONS + 1; i++)
+	// leakage does not depend on activity, only the cycle counts
+	idleLeakage(1);
+    }
+}
+
+void Router::checkpoint(Checkpoint & cp)
+{
+    for (int i = 0; i < DIRECTIONS + 2; i++)
+    {
+	for (int vc = 0; vc < GlobalParams::n_virtual_channels; vc++)
+	    buffer[i][vc].checkpoint(cp);
+	cp.transfer(current_level_rx[i]);
+	cp.transfer(current_level_tx[i]);
+	cp.transfer(start_from_vc[i]);
+    }
+    cp.transfer(start_from_port);
+    cp.transfer(routed_flits);
+    cp.transfer(local_drained);
+    cp.transfer(buffered_flits);
+    cp.transfer(idle_cycles);
+    rng.checkpoint(cp);
+
+    reservation_table.checkpoint(cp);
+    stats.checkpoint(cp);
+    power.checkpoint(cp);
+}
+
+void Router::idleLeakage(unsigned long long cycles)
+{
+    // same contributions perCycleUpdate accounts for on every cycle, one
+    // per buffer and link of each input
+    unsigned long long buffers = cycles * (DIRECTIONS + 1) * GlobalParams::n_virtual_channels;
+
+    power.leakageRouter(cycles);
+    power.leakageBufferRouter(buffers);
+    power.leakageLinkRouter2Router(buffers);
+    power.leakageLinkRouter2Hub(cycles);
+}
+
+// Tabulates the outputs of a deterministic routing algorithm for all the
+// destinations and source classes seen from this router
+void Router::buildRouteTable()
+{
+    int n_nodes = GlobalParams::mesh_dim_x * GlobalParams::mesh_dim_y;
+    int classes = routingAlgorithm->sourceClasses();
+
+    route_table.assign(classes * n_nodes, 0);
+
+    RouteData route_data;
+    route_data.current_id = local_id;
+    route_data.dir_in = NOT_VALID;
+    route_data.vc_id = DEFAULT_VC;
+
+    // any source of a class gives the outputs of the whole class
+    vector<int> sources(classes, NOT_VALID);
+    for (int src = 0; src < n_nodes; src++)
+    {
+	route_data.src_id = src;
+	int c = routingAlgorithm->sourceClass(route_data);
+	if (sources[c] == NOT_VALID)
+	    sources[c] = src;
+    }
+
+    for (int c = 0; c < classes; c++)
+    {
+	if (sources[c] == NOT_VALID)
+	    continue;
+	route_data.src_id = sources[c];
+	for (int dst = 0; dst < n_nodes; dst++)
 	{
-	    for (int vc=0;vc<GlobalParams::n_virtual_channels;vc++)
-	    {
-		power.leakageBufferRouter();
-		power.leakageLinkRouter2Router();
-	    }
+	    // route() handles the local destination itself
+	    if (dst == local_id)
+		continue;
+	    route_data.dst_id = dst;
+	    route_table[c * n_nodes + dst] = routingAlgorithm->route(this, route_data);
 	}
-
-	power.leakageLinkRouter2Hub();
     }
 }
 
-vector < int > Router::routingFunction(const RouteData & route_data)
+unsigned int Router::routingFunction(const RouteData & route_data)
 {
     if (GlobalParams::use_winoc)
     {
@@ -293,14 +402,18 @@ vector < int > Router::routingFunction(const RouteData & route_data)
 		if (GlobalParams::verbose_mode > VERBOSE_OFF) 
 		    LOG << "Setting direction HUB to reach destination node " << route_data.dst_id << endl;
 
-		vector<int> dirv;
-		dirv.push_back(DIRECTION_HUB);
-		return dirv;
+		return DIRECTION_MASK(DIRECTION_HUB);
         }
     }
     if (GlobalParams::verbose_mode > VERBOSE_OFF) 
 	LOG << "Wired routing for dst = " << route_data.dst_id << endl;
 
+    // the table covers this router only, NoP selection also routes from
+    // the neighbors
+    if (!route_table.empty() && route_data.current_id == local_id)
+	return route_table[routingAlgorithm->sourceClass(route_data) *
+			   GlobalParams::mesh_dim_x * GlobalParams::mesh_dim_y + route_data.dst_id];
+
     return routingAlgorithm->route(this, route_data);
 }
 
@@ -311,7 +424,7 @@ int Router::route(const RouteData & route_data)
 	return DIRECTION_LOCAL;
 
     power.routing();
-    vector < int >candidate_channels = routingFunction(route_data);
+    unsigned int candidate_channels = routingFunction(route_data);
 
     power.selection();
     return selectionFunction(candidate_channels, route_data);
@@ -332,20 +445,21 @@ void Router::NoP_report() const
 //---------------------------------------------------------------------------
 
 int Router::NoPScore(const NoP_data & nop_data,
-			  const vector < int >&nop_channels) const
+			  unsigned int nop_channels) const
 {
     int score = 0;
 
-    for (unsigned int i = 0; i < nop_channels.size(); i++) {
+    for (; nop_channels; nop_channels &= nop_channels - 1) {
+	int direction = __builtin_ctz(nop_channels);
 	int available;
 
-	if (nop_data.channel_status_neighbor[nop_channels[i]].available)
+	if (nop_data.channel_status_neighbor[direction].available)
 	    available = 1;
 	else
 	    available = 0;
 
 	int free_slots =
-	    nop_data.channel_status_neighbor[nop_channels[i]].free_slots;
+	    nop_data.channel_status_neighbor[direction].free_slots;
 
 	score += available * free_slots;
     }
@@ -353,14 +467,20 @@ int Router::NoPScore(const NoP_data & nop_data,
     return score;
 }
 
-int Router::selectionFunction(const vector < int >&directions,
+int Router::selectionFunction(unsigned int directions,
 				   const RouteData & route_data)
 {
+    assert(directions != 0);
+
     // not so elegant but fast escape ;)
-    if (directions.size() == 1)
-	return directions[0];
+    if ((directions & (directions - 1)) == 0)
+	return __builtin_ctz(directions);
+
+    candidate_directions.clear();
+    for (; directions; directions &= directions - 1)
+	candidate_directions.push_back(__builtin_ctz(directions));
 
-    return selectionStrategy->apply(this, directions, route_data);
+    return selectionStrategy->apply(this, candidate_directions, route_data);
 }
 
 void Router::configure(const int _id,
@@ -377,6 +497,9 @@ void Router::configure(const int _id,
     if (grt.isValid())
 	routing_table.configure(grt, _id);
 
+    if (GlobalParams::precompute_routing && routingAlgorithm->isTabulable())
+	buildRouteTable();
+
     reservation_table.setSize(DIRECTIONS+2);
 
     for (int i = 0; i < DIRECTIONS + 2; i++)
@@ -19,6 +19,7 @@
 #include "LocalRoutingTable.h"
 #include "ReservationTable.h"
 #include "Utils.h"
+#include "RandomStream.h"
 #include "routingAlgorithms/RoutingAlgorithm.h"
 #include "routingAlgorithms/RoutingAlgorithms.h"
 #include "selectionStrategies/SelectionStrategy.h"
@@ -40,12 +41,12 @@ SC_MODULE(Router)
     sc_in <bool> reset;                           // The reset signal for the router
 
     // number of ports: 4 mesh directions + local + wireless 
-    sc_in <Flit> flit_rx[DIRECTIONS + 2];	  // The input channels 
+    sc_in <FlitHandle> flit_rx[DIRECTIONS + 2];	  // The input channels 
     sc_in <bool> req_rx[DIRECTIONS + 2];	  // The requests associated with the input channels
     sc_out <bool> ack_rx[DIRECTIONS + 2];	  // The outgoing ack signals associated with the input channels
     sc_out <TBufferFullStatus> buffer_full_status_rx[DIRECTIONS+2];
 
-    sc_out <Flit> flit_tx[DIRECTIONS + 2];   // The output channels
+    sc_out <FlitHandle> flit_tx[DIRECTIONS + 2];   // The output channels
     sc_out <bool> req_tx[DIRECTIONS + 2];	  // The requests associated with the output channels
     sc_in <bool> ack_tx[DIRECTIONS + 2];	  // The outgoing ack signals associated with the output channels
     sc_in <TBufferFullStatus> buffer_full_status_tx[DIRECTIONS+2];
@@ -70,6 +71,7 @@ SC_MODULE(Router)
     LocalRoutingTable routing_table;		// Routing table
     ReservationTable reservation_table;		// Switch reservation table
     unsigned long routed_flits;
+    RandomStream rng;				// Random numbers of this router
     RoutingAlgorithm * routingAlgorithm; 
     SelectionStrategy * selectionStrategy; 
     
@@ -79,6 +81,8 @@ SC_MODULE(Router)
     void rxProcess();		// The receiving process
     void txProcess();		// The transmitting process
     void perCycleUpdate();
+    void idleLeakage(unsigned long long cycles);	// Leakage of cycles skipped by fast-forward
+    void checkpoint(Checkpoint & cp);	// Saves or restores buffers, arbitration and statistics
     void configure(const int _id, const double _warm_up_time,
 		   const unsigned int _max_buffer_size,
 		   GlobalRoutingTable & grt);
@@ -88,13 +92,20 @@ SC_MODULE(Router)
     // Constructor
 
     SC_CTOR(Router) {
-        SC_METHOD(process);
-        sensitive << reset;
-        sensitive << clock.pos();
+        buffered_flits = 0;
+        idle_cycles = 0;
 
-        SC_METHOD(perCycleUpdate);
-        sensitive << reset;
-        sensitive << clock.pos();
+        // with the flat engine NoC::evaluate() calls the processes
+        if (!GlobalParams::flat_engine)
+        {
+            SC_METHOD(process);
+            sensitive << reset;
+            sensitive << clock.pos();
+
+            SC_METHOD(perCycleUpdate);
+            sensitive << reset;
+            sensitive << clock.pos();
+        }
 
         routingAlgorithm = RoutingAlgorithms::get(GlobalParams::routing_algorithm);
 
@@ -119,19 +130,29 @@ SC_MODULE(Router)
     int route(const RouteData & route_data);
 
     // wrappers
-    int selectionFunction(const vector <int> &directions,
+    int selectionFunction(unsigned int directions,
 			  const RouteData & route_data);
-    vector < int >routingFunction(const RouteData & route_data);
+    unsigned int routingFunction(const RouteData & route_data);	// DIRECTION_MASK() of the candidates
+    void buildRouteTable();
+
+    vector<unsigned char> route_table;	// [source class][destination] -> routingAlgorithm mask
+    vector<int> candidate_directions;	// passed to the selection strategy
  
     NoP_data getCurrentNoPData();
     void NoP_report() const;
-    int NoPScore(const NoP_data & nop_data, const vector <int> & nop_channels) const;
+    int NoPScore(const NoP_data & nop_data, unsigned int nop_channels) const;
     int reflexDirection(int direction) const;
     int getNeighborId(int _id, int direction) const;
    
     int start_from_port;	     // Port from which to start the reservation cycle
     int start_from_vc[DIRECTIONS+2]; // VC from which to start the reservation cycle for the specific port
 
+    // activity gating
+    bool isIdle();		     // Nothing buffered, reserved or arriving
+    void catchUp();		     // Rotates the arbitration pointers over the skipped cycles
+    int buffered_flits;		     // Flits in all the input buffers
+    unsigned long idle_cycles;	     // Evaluations skipped since the last active cycle
+
   public:
     unsigned int local_drained;
 
@@ -8,7 +8,10 @@
  * This file contains the implementation of the statistics
  */
 
+#include <cmath>
 #include "Stats.h"
+#include "Utils.h"
+#include "Checkpoint.h"
 
 // TODO: nan in averageDelay
 
@@ -18,7 +21,7 @@ void Stats::configure(const int node_id, const double _warm_up_time)
     warm_up_time = _warm_up_time;
 }
 
-void Stats::receivedFlit(const double arrival_time,
+void Stats::receivedFlit(const long long arrival_time,
 			      const Flit & flit)
 {
     if (arrival_time - GlobalParams::reset_time < warm_up_time)
@@ -32,14 +35,30 @@ void Stats::receivedFlit(const double arrival_time,
 	CommHistory ch;
 
 	ch.src_id = flit.src_id;
+	ch.received_packets = 0;
+	ch.delay_sum = 0.0;
+	ch.delay_min = ch.delay_max = -1.0;
 	ch.total_received_flits = 0;
 	chist.push_back(ch);
 
 	i = chist.size() - 1;
+	if (flit.src_id >= (int) chist_index.size())
+	    chist_index.resize(flit.src_id + 1, -1);
+	chist_index[flit.src_id] = i;
     }
 
-    if (flit.flit_type == FLIT_TYPE_HEAD)
-	chist[i].delays.push_back(arrival_time - flit.timestamp);
+    if (flit.flit_type == FLIT_TYPE_HEAD) {
+	double delay = arrival_time - flit.timestamp;
+	CommHistory & ch = chist[i];
+
+	if (ch.received_packets == 0 || delay < ch.delay_min)
+	    ch.delay_min = delay;
+	if (ch.received_packets == 0 || delay > ch.delay_max)
+	    ch.delay_max = delay;
+	ch.delay_sum += delay;
+	ch.received_packets++;
+	delay_histogram.add(delay);
+    }
 
     chist[i].total_received_flits++;
     chist[i].last_received_flit_time = arrival_time - warm_up_time;
@@ -47,58 +66,39 @@ void Stats::receivedFlit(const double arrival_time,
 
 double Stats::getAverageDelay(const int src_id)
 {
-    double sum = 0.0;
-
     int i = searchCommHistory(src_id);
 
     assert(i >= 0);
 
-    for (unsigned int j = 0; j < chist[i].delays.size(); j++)
-	sum += chist[i].delays[j];
-
-    return sum / (double) chist[i].delays.size();
+    return chist[i].delay_sum / (double) chist[i].received_packets;
 }
 
 double Stats::getAverageDelay()
 {
-    double avg = 0.0;
+    double sum = 0.0;
 
-    for (unsigned int k = 0; k < chist.size(); k++) {
-	unsigned int samples = chist[k].delays.size();
-	if (samples)
-	    avg += (double) samples *getAverageDelay(chist[k].src_id);
-    }
+    for (unsigned int k = 0; k < chist.size(); k++)
+	sum += chist[k].delay_sum;
 
-    return avg / (double) getReceivedPackets();
+    return sum / (double) getReceivedPackets();
 }
 
 double Stats::getMaxDelay(const int src_id)
 {
-    double maxd = -1.0;
-
     int i = searchCommHistory(src_id);
 
     assert(i >= 0);
 
-    for (unsigned int j = 0; j < chist[i].delays.size(); j++)
-	if (chist[i].delays[j] > maxd) {
-	    maxd = chist[i].delays[j];
-	}
-    return maxd;
+    return chist[i].delay_max;
 }
 
 double Stats::getMaxDelay()
 {
     double maxd = -1.0;
 
-    for (unsigned int k = 0; k < chist.size(); k++) {
-	unsigned int samples = chist[k].delays.size();
-	if (samples) {
-	    double m = getMaxDelay(chist[k].src_id);
-	    if (m > maxd)
-		maxd = m;
-	}
-    }
+    for (unsigned int k = 0; k < chist.size(); k++)
+	if (chist[k].received_packets && chist[k].delay_max > maxd)
+	    maxd = chist[k].delay_max;
 
     return maxd;
 }
@@ -112,7 +112,7 @@ double Stats::getAverageThroughput(const int src_id)
     // not using GlobalParams::simulation_time since 
     // the value must takes into account the invokation time
     // (when called before simulation ended, e.g. turi signal)
-    int current_sim_cycles = sc_time_stamp().to_double()/GlobalParams::clock_period_ps - warm_up_time - GlobalParams::reset_time;
+    int current_sim_cycles = currentCycle() - warm_up_time - GlobalParams::reset_time + skipped_cycles;
 
     if (chist[i].total_received_flits == 0)
 	return -1.0;
@@ -139,7 +139,7 @@ unsigned int Stats::getReceivedPackets()
     int n = 0;
 
     for (unsigned int i = 0; i < chist.size(); i++)
-	n += chist[i].delays.size();
+	n += chist[i].received_packets;
 
     return n;
 }
@@ -183,15 +183,6 @@ double Stats::getCommunicationEnergy(int src_id, int dst_id)
   return -1.0;
 }
 
-int Stats::searchCommHistory(int src_id)
-{
-    for (unsigned int i = 0; i < chist.size(); i++)
-	if (chist[i].src_id == src_id)
-	    return i;
-
-    return -1;
-}
-
 void Stats::showStats(int curr_node, std::ostream & out, bool header)
 {
     if (header) {
@@ -221,7 +212,7 @@ void Stats::showStats(int curr_node, std::ostream & out, bool header)
 	    << setw(15) << getAverageThroughput(chist[i].src_id)
 	    << setw(13) << getCommunicationEnergy(chist[i].src_id,
 						  curr_node)
-	    << setw(12) << chist[i].delays.size()
+	    << setw(12) << chist[i].received_packets
 	    << setw(12) << chist[i].total_received_flits << endl;
     }
 
@@ -230,3 +221,82 @@ void Stats::showStats(int curr_node, std::ostream & out, bool header)
     out << "% Aggregated average throughput (flits/cycle): " <<
 	getAverageThroughput() << endl;
 }
+
+void Stats::checkpoint(Checkpoint & cp)
+{
+    cp.transfer(chist);
+    delay_histogram.checkpoint(cp);
+
+    if (!cp.isSaving()) {
+	chist_index.clear();
+	for (unsigned int i = 0; i < chist.size(); i++) {
+	    if (chist[i].src_id >= (int) chist_index.size())
+		chist_index.resize(chist[i].src_id + 1, -1);
+	    chist_index[chist[i].src_id] = i;
+	}
+    }
+}
+
+void LatencyHistogram::add(const double delay)
+{
+    unsigned long long v = delay > 0.0 ? (unsigned long long) delay : 0;
+    unsigned int bucket;
+
+    if (v < LATENCY_HISTOGRAM_SUB)
+	bucket = v;
+    else {
+	// the leading one selects the power of two, the next SUB_BITS bits
+	// the bucket within it
+	int msb = 63 - __builtin_clzll(v);
+	int shift = msb - LATENCY_HISTOGRAM_SUB_BITS;
+	bucket = ((shift + 1) << LATENCY_HISTOGRAM_SUB_BITS) +
+	    (unsigned int) ((v >> shift) - LATENCY_HISTOGRAM_SUB);
+    }
+
+    if (bucket >= counts.size())
+	counts.resize(bucket + 1, 0);
+    counts[bucket]++;
+    samples++;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram & h)
+{
+    if (h.counts.size() > counts.size())
+	counts.resize(h.counts.size(), 0);
+    for (unsigned int i = 0; i < h.counts.size(); i++)
+	counts[i] += h.counts[i];
+    samples += h.samples;
+}
+
+double LatencyHistogram::getPercentile(const double q) const
+{
+    if (samples == 0)
+	return -1.0;
+
+    // rank of the sample wanted, from 1
+    unsigned long long rank = (unsigned long long) ceil(q * samples);
+    if (rank < 1)
+	rank = 1;
+    if (rank > samples)
+	rank = samples;
+
+    unsigned long long seen = 0;
+    unsigned int bucket = 0;
+    while (seen + counts[bucket] < rank)
+	seen += counts[bucket++];
+
+    if (bucket < LATENCY_HISTOGRAM_SUB)
+	return bucket;
+
+    // middle of the delays the bucket stands for
+    int shift = (bucket >> LATENCY_HISTOGRAM_SUB_BITS) - 1;
+    unsigned long long low = (unsigned long long)
+	(LATENCY_HISTOGRAM_SUB + (bucket & (LATENCY_HISTOGRAM_SUB - 1))) << shift;
+    return low + ((1ULL << shift) - 1) / 2.0;
+}
+
+void LatencyHistogram::checkpoint(Checkpoint & cp)
+{
+    cp.transfer(counts);
+    cp.transfer(samples);
+}
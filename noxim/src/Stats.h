@@ -18,13 +18,50 @@
 #include "Power.h"
 using namespace std;
 
+class Checkpoint;
+
 struct CommHistory {
     int src_id;
-     vector < double >delays;
+    unsigned int received_packets;
+    double delay_sum;
+    double delay_min;
+    double delay_max;
     unsigned int total_received_flits;
     double last_received_flit_time;
 };
 
+// Bucket bits below the leading one: delays under 2^LATENCY_HISTOGRAM_SUB_BITS
+// cycles get a bucket each, larger ones are kept within 1/2^SUB_BITS
+#define LATENCY_HISTOGRAM_SUB_BITS	5
+#define LATENCY_HISTOGRAM_SUB		(1 << LATENCY_HISTOGRAM_SUB_BITS)
+
+// Log-bucketed histogram of packet delays. Its size depends on the largest
+// delay only, and histograms of different nodes add up with merge().
+class LatencyHistogram {
+
+  public:
+
+    LatencyHistogram() : samples(0) {
+    }
+
+    void add(const double delay);
+    void merge(const LatencyHistogram & h);
+
+    unsigned long long getSamples() const {
+	return samples;
+    }
+
+    // Delay below which a fraction q of the samples are, -1 if empty
+    double getPercentile(const double q) const;
+
+    void checkpoint(Checkpoint & cp);
+
+  private:
+
+    vector < unsigned long long > counts;
+    unsigned long long samples;
+};
+
 class Stats {
 
   public:
@@ -35,7 +72,7 @@ class Stats {
     void configure(const int node_id, const double _warm_up_time);
 
     // Access point for stats update
-    void receivedFlit(const double arrival_time, const Flit & flit);
+    void receivedFlit(const long long arrival_time, const Flit & flit);
 
     // Returns the average delay (cycles) for the current node as
     // regards to the communication whose source is src_id
@@ -78,14 +115,26 @@ class Stats {
     void showStats(int curr_node, std::ostream & out =
 		   std::cout, bool header = false);
 
+    // Delays of all the packets received by the current node
+    const LatencyHistogram & getDelayHistogram() const {
+	return delay_histogram;
+    }
+
+    // Saves or restores the communication history
+    void checkpoint(Checkpoint & cp);
+
 
   private:
 
     int id;
-    vector < CommHistory > chist;
+    vector < CommHistory > chist;	// In order of first arrival
+    vector < int > chist_index;		// src_id -> chist entry, -1 if none
+    LatencyHistogram delay_histogram;
     double warm_up_time;
 
-    int searchCommHistory(int src_id);
+    int searchCommHistory(int src_id) const {
+	return src_id >= 0 && src_id < (int) chist_index.size() ? chist_index[src_id] : -1;
+    }
 };
 
 #endif
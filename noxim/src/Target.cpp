@@ -12,7 +12,8 @@
 
 void Target::b_transport( tlm::tlm_generic_payload& trans, sc_time& delay )
 {
-    struct Flit* my_flit = (struct Flit*)trans.get_data_ptr();
+    FlitHandle handle = *(FlitHandle*)trans.get_data_ptr();
+    const Flit* my_flit = &FlitPool::get(handle);
 
     LOG << "*** [Ch" <<local_id << "] Received: " << *my_flit << endl;
 
@@ -22,7 +23,7 @@ void Target::b_transport( tlm::tlm_generic_payload& trans, sc_time& delay )
     if (!buffer_rx.IsFull())
     {
 	LOG << "*** [Ch" <<local_id << "] Flit " << *my_flit << " moved to buffer_rx " << endl;
-	buffer_rx.Push(*my_flit);
+	buffer_rx.Push(handle);
 	hub->power.antennaBufferPush();
 	// Obliged to set response status to indicate successful completion
 	trans.set_response_status( tlm::TLM_OK_RESPONSE );
@@ -44,7 +44,7 @@ SC_MODULE(TokenRing)
     TokenRing(sc_module_name nm): sc_module(nm) {
 
 
-	if (GlobalParams::use_winoc)
+	if (GlobalParams::use_winoc && !GlobalParams::flat_engine)
 	{
 	    SC_METHOD(updateTokens);
 	    sensitive << reset;
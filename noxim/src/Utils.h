@@ -20,7 +20,7 @@
 
 #ifdef DEBUG
 
-#define LOG (std::cout << std::setw(7) << left << sc_time_stamp().to_double() / GlobalParams::clock_period_ps << " " << name() << "::" << __func__<< "() --> ")
+#define LOG (std::cout << std::setw(7) << left << currentCycle() << " " << name() << "::" << __func__<< "() --> ")
 
 #else
 template <class cT, class traits = std::char_traits<cT> >
@@ -53,6 +53,29 @@ static onullstream LOG;
 
 #endif
 
+// Cycles jumped over by the netrace idle fast-forward (see NoC::fastForward).
+// Throughput is measured on this extended time axis.
+extern unsigned long long skipped_cycles;
+
+// Trace cycle = simulated cycle + trace_cycle_offset. Moves with the idle
+// fast-forward and with the jumps between sampled trace windows.
+extern long long trace_cycle_offset;
+
+// Cycles simulated before this run started, by the run that saved the
+// checkpoint it was restored from (see NoC::checkpoint)
+extern long long cycle_base;
+
+// Clock cycles of this run, advanced by NoC::countCycle() on each falling
+// edge: every process woken by a rising edge sees the same value, the
+// number of rising edges before it
+extern unsigned long long clock_cycles;
+
+// Current clock cycle
+inline long long currentCycle()
+{
+    return (long long) clock_cycles + cycle_base;
+}
+
 // Output overloading
 
 inline ostream & operator <<(ostream & os, const Flit & flit)
@@ -76,7 +99,7 @@ inline ostream & operator <<(ostream & os, const Flit & flit)
 	}
 	os << "Sequence no. " << flit.sequence_no << endl;
 	os << "Payload printing not implemented (yet)." << endl;
-	os << "Unix timestamp at packet generation " << flit.
+	os << "Cycle of packet generation " << flit.
 	    timestamp << endl;
 	os << "Total number of hops from source to destination is " <<
 	    flit.hop_no << endl;
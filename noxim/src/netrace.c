@@ -28,8 +28,20 @@
 
 #include "netrace.h"
 
-char*				nt_input_popencmd;
 FILE*				nt_input_tracefile;
+BZFILE*				nt_input_bzfile;
+unsigned long long int nt_input_offset;
+int					nt_input_eof;
+nt_index_entry_t*	nt_input_index;
+unsigned int		nt_input_index_size;
+char*				nt_input_map;
+size_t				nt_input_map_size;
+nt_native_header_t*	nt_native;
+nt_native_packet_t*	nt_native_packets;
+nt_dependency_t*	nt_native_deps;
+unsigned long long int nt_native_next;
+nt_packet_t*		nt_input_pending;
+unsigned long long int nt_input_position;
 char*				nt_input_buffer;
 nt_header_t*		nt_input_trheader;
 int					nt_dependencies_off;
@@ -38,6 +50,20 @@ int					nt_primed_self_throttle;
 int					nt_done_reading;
 unsigned long long int nt_latest_active_packet_cycle;
 nt_dep_ref_node_t** nt_dependency_array;
+unsigned int		nt_dependency_array_size;
+unsigned int		nt_dependency_count;
+nt_pool_t			nt_dependency_pool;
+nt_pool_t			nt_packet_pool = NT_POOL_INITIALIZER( sizeof(nt_packet_t), 1 );
+nt_pool_t			nt_dependency_array_pools[NT_DEPENDENCY_CLASSES] = {
+	NT_POOL_INITIALIZER( 2 * sizeof(nt_dependency_t), 1 ),
+	NT_POOL_INITIALIZER( 4 * sizeof(nt_dependency_t), 1 ),
+	NT_POOL_INITIALIZER( 8 * sizeof(nt_dependency_t), 1 ),
+	NT_POOL_INITIALIZER( 16 * sizeof(nt_dependency_t), 1 ),
+	NT_POOL_INITIALIZER( 32 * sizeof(nt_dependency_t), 1 ),
+	NT_POOL_INITIALIZER( 64 * sizeof(nt_dependency_t), 1 ),
+	NT_POOL_INITIALIZER( 128 * sizeof(nt_dependency_t), 1 ),
+	NT_POOL_INITIALIZER( 256 * sizeof(nt_dependency_t), 1 ) };
+nt_pool_t			nt_packet_list_pool = NT_POOL_INITIALIZER( sizeof(nt_packet_list_t), 0 );
 unsigned long long int nt_num_active_packets;
 const char* nt_packet_types[] = { "InvalidCmd", "ReadReq", "ReadResp",
 				"ReadRespWithInvalidate", "WriteReq", "WriteResp",
@@ -65,22 +91,39 @@ const char* nt_node_types[] = { "L1 Data Cache", "L1 Instruction Cache",
 nt_packet_list_t*	nt_cleared_packets_list;
 nt_packet_list_t*	nt_cleared_packets_list_tail;
 int nt_track_cleared_packets_list;
+int					nt_prefetch_on;
+unsigned int		nt_prefetch_depth;
+nt_packet_t**		nt_prefetch_ring;
+unsigned long long int* nt_prefetch_positions;
+pthread_t			nt_prefetch_thread;
+// Single-producer single-consumer ring: only the simulator advances head and
+// only the prefetch thread advances tail, so neither side ever takes a lock
+atomic_ullong		nt_prefetch_head;
+atomic_ullong		nt_prefetch_tail;
+atomic_int			nt_prefetch_eof;
+atomic_int			nt_prefetch_stop;
 
 void nt_open_trfile( const char* trfilename ) {
 	nt_close_trfile();
-	int i;
-	int length = 20;
-	for( i = 0; trfilename[i] != 0; i++, length++ );
-	nt_input_popencmd = (char*) nt_checked_malloc( length * sizeof(char) );
-	sprintf( nt_input_popencmd, "bzip2 -dc %s", trfilename );
-	nt_input_tracefile = popen( nt_input_popencmd, "r" );
+	nt_input_tracefile = fopen( trfilename, "rb" );
 	if( nt_input_tracefile == NULL ) {
-		nt_error( "failed to open pipe to trace file" );
+		nt_error( "failed to open trace file" );
+	}
+	unsigned int magic = 0;
+	if( fread( &magic, sizeof(unsigned int), 1, nt_input_tracefile ) == 1 && magic == NT_NATIVE_MAGIC ) {
+		nt_map_native();
+	} else {
+		nt_load_index( trfilename );
 	}
+	nt_trfile_reopen( 0, 0 );
 	nt_input_trheader = nt_read_trheader();
+	nt_input_position = nt_decode_position();
 	if( nt_dependency_array == NULL ) {
 		nt_dependency_array = nt_checked_malloc( sizeof(nt_dep_ref_node_t*) * NT_DEPENDENCY_ARRAY_SIZE );
 		memset( nt_dependency_array, 0, sizeof(nt_dep_ref_node_t*) * NT_DEPENDENCY_ARRAY_SIZE );
+		nt_dependency_array_size = NT_DEPENDENCY_ARRAY_SIZE;
+		nt_dependency_count = 0;
+		nt_pool_init( &nt_dependency_pool, sizeof(nt_dep_ref_node_t), NT_POOL_SLAB_BYTES / sizeof(nt_dep_ref_node_t) );
 		nt_num_active_packets = 0;
 	} else {
 		nt_error( "dependency array not NULL on file open" );
@@ -109,8 +152,7 @@ nt_header_t* nt_read_trheader() {
 
 	// Read Header
 	struct nt_header_pack* in_header = nt_checked_malloc( sizeof(struct nt_header_pack) );
-	fseek( nt_input_tracefile, 0, SEEK_SET );
-	if( (err = fread( in_header, sizeof(struct nt_header_pack), 1, nt_input_tracefile )) < 0 ) {
+	if( (err = nt_trfile_read( in_header, sizeof(struct nt_header_pack) )) < sizeof(struct nt_header_pack) ) {
 		sprintf( strerr, "failed to read trace file header: err = %d", err );
 		nt_error( strerr );
 	}
@@ -143,7 +185,7 @@ nt_header_t* nt_read_trheader() {
 	// Read Rest of Header
 	if( to_return->notes_length > 0 && to_return->notes_length < 8192 ) {
 		to_return->notes = (char*) nt_checked_malloc( to_return->notes_length * sizeof(char) );
-		if( (err = fread( to_return->notes, sizeof(char), to_return->notes_length, nt_input_tracefile )) < 0 ) {
+		if( (err = nt_trfile_read( to_return->notes, to_return->notes_length * sizeof(char) )) < to_return->notes_length * sizeof(char) ) {
 			sprintf( strerr, "failed to read trace file header notes: err = %d\n", err );
 			nt_error( strerr );
 		}
@@ -153,7 +195,7 @@ nt_header_t* nt_read_trheader() {
 	if( to_return->num_regions > 0 ) {
 		if( to_return->num_regions <= 100 ) {
 			to_return->regions = (nt_regionhead_t*) nt_checked_malloc( to_return->num_regions * sizeof(nt_regionhead_t) );
-			if( (err = fread( to_return->regions, sizeof(nt_regionhead_t), to_return->num_regions, nt_input_tracefile )) < 0 ) {
+			if( (err = nt_trfile_read( to_return->regions, to_return->num_regions * sizeof(nt_regionhead_t) )) < to_return->num_regions * sizeof(nt_regionhead_t) ) {
 				sprintf( strerr, "failed to read trace file header regions: error = %d\n", err );
 				nt_error( strerr );
 			}
@@ -174,31 +216,34 @@ void nt_disable_dependencies() {
 }
 
 void nt_seek_region( nt_regionhead_t* region ) {
-	int err = 0;
-	char strerr[180];
 	if( nt_input_tracefile != NULL ) {
 		if( region != NULL ) {
+			// The decoder thread reads from the stream we are about to move
+			int prefetch = nt_prefetch_on;
+			if( prefetch ) {
+				nt_stop_prefetch();
+			}
 			// Clear all existing dependencies
 			nt_delete_all_dependencies();
-			// Reopen file to fast-forward to region
-			// fseek doesn't work on compressed file
-			pclose( nt_input_tracefile );
-			nt_input_tracefile = popen( nt_input_popencmd, "r" );
-            unsigned long long int seek_offset = nt_get_headersize() + region->seek_offset;
-            unsigned long long int read_length = 4096;
-			char* buffer = (char*) nt_checked_malloc( read_length );
-			while( seek_offset > read_length ) {
-				if( (err = fread( buffer, 1, read_length, nt_input_tracefile )) < 0 ) {
-					sprintf( strerr, "failed to seek region: error = %d\n", err );
-					nt_error( strerr );
+			if( nt_input_pending != NULL ) {
+				nt_packet_free( nt_input_pending );
+				nt_input_pending = NULL;
+			}
+			if( nt_input_map != NULL ) {
+				nt_native_region_t* regions = (nt_native_region_t*) ( nt_input_map + nt_native->regions_offset );
+				unsigned int i;
+				for( i = 0; i < nt_native->num_regions && regions[i].seek_offset != region->seek_offset; i++ );
+				if( i == nt_native->num_regions ) {
+					nt_error( "region not found in native trace file" );
 				}
-				seek_offset -= read_length;
+				nt_native_next = regions[i].first_packet;
+			} else {
+				nt_trfile_seek( nt_get_headersize() + region->seek_offset );
 			}
-			if( (err = fread( buffer, 1, seek_offset, nt_input_tracefile )) < 0 ) {
-				sprintf( strerr, "failed to seek region: error = %d\n", err );
-				nt_error( strerr );
+			nt_input_position = nt_decode_position();
+			if( prefetch ) {
+				nt_init_prefetch( nt_prefetch_depth );
 			}
-			free( buffer );
 			if( nt_self_throttling ) {
 				// Prime the pump to read in self throttled packets
 				nt_prime_self_throttle();
@@ -211,7 +256,262 @@ void nt_seek_region( nt_regionhead_t* region ) {
 	}
 }
 
+void nt_load_index( const char* trfilename ) {
+	char* idxname = (char*) nt_checked_malloc( strlen( trfilename ) + strlen( NT_INDEX_SUFFIX ) + 1 );
+	sprintf( idxname, "%s%s", trfilename, NT_INDEX_SUFFIX );
+	nt_input_index = NULL;
+	nt_input_index_size = 0;
+	FILE* fp = fopen( idxname, "rb" );
+	free( idxname );
+	if( fp == NULL ) {
+		// No sidecar index: seeks decompress the prefix instead
+		return;
+	}
+	nt_index_header_t header;
+	if( fread( &header, sizeof(nt_index_header_t), 1, fp ) != 1 || header.magic != NT_INDEX_MAGIC ) {
+		nt_error( "invalid trace index file: bad magic" );
+	}
+	struct stat st;
+	if( header.version != NT_INDEX_VERSION || stat( trfilename, &st ) != 0 ||
+			header.source_size != (unsigned long long int) st.st_size ||
+			header.source_mtime != (long long int) st.st_mtime ) {
+		// Built for another version of the trace (or by an older nt_reindex)
+		fprintf( stderr, "WARNING: ignoring stale trace index for %s, rerun nt_reindex\n", trfilename );
+		fclose( fp );
+		return;
+	}
+	unsigned int count = header.count;
+	if( count > 0 ) {
+		nt_input_index = (nt_index_entry_t*) nt_checked_malloc( count * sizeof(nt_index_entry_t) );
+		if( fread( nt_input_index, sizeof(nt_index_entry_t), count, fp ) != count ) {
+			nt_error( "invalid trace index file: truncated" );
+		}
+	}
+	nt_input_index_size = count;
+	fclose( fp );
+}
+
+void nt_map_native( void ) {
+	fseeko( nt_input_tracefile, 0, SEEK_END );
+	nt_input_map_size = (size_t) ftello( nt_input_tracefile );
+	if( nt_input_map_size < sizeof(nt_native_header_t) ) {
+		nt_error( "invalid native trace file: truncated" );
+	}
+	nt_input_map = mmap( NULL, nt_input_map_size, PROT_READ, MAP_PRIVATE, fileno( nt_input_tracefile ), 0 );
+	if( nt_input_map == MAP_FAILED ) {
+		nt_input_map = NULL;
+		nt_error( "failed to map native trace file" );
+	}
+	nt_native = (nt_native_header_t*) nt_input_map;
+	if( nt_native->version != NT_NATIVE_VERSION ) {
+		nt_error( "native trace file is unsupported version" );
+	}
+	if( nt_native->packets_offset + nt_native->num_packets * sizeof(nt_native_packet_t) > nt_input_map_size ||
+			nt_native->deps_offset + nt_native->num_deps * sizeof(nt_dependency_t) > nt_input_map_size ) {
+		nt_error( "invalid native trace file: truncated" );
+	}
+	nt_native_packets = (nt_native_packet_t*) ( nt_input_map + nt_native->packets_offset );
+	nt_native_deps = (nt_dependency_t*) ( nt_input_map + nt_native->deps_offset );
+	nt_native_next = 0;
+	// Packets are consumed front to back
+	madvise( nt_input_map + nt_native->packets_offset, nt_native->num_packets * sizeof(nt_native_packet_t), MADV_SEQUENTIAL );
+}
+
+void nt_trfile_reopen( unsigned long long int raw_offset, unsigned long long int file_offset ) {
+	int bzerr;
+	if( nt_input_map != NULL ) {
+		// Only the embedded netrace header is read as a byte stream
+		nt_input_offset = raw_offset;
+		nt_input_eof = 0;
+		return;
+	}
+	if( nt_input_bzfile != NULL ) {
+		BZ2_bzReadClose( &bzerr, nt_input_bzfile );
+	}
+	if( fseeko( nt_input_tracefile, (off_t) file_offset, SEEK_SET ) != 0 ) {
+		nt_error( "failed to seek in trace file" );
+	}
+	nt_input_bzfile = BZ2_bzReadOpen( &bzerr, nt_input_tracefile, 0, 0, NULL, 0 );
+	if( bzerr != BZ_OK ) {
+		nt_error( "failed to open bzip2 stream in trace file" );
+	}
+	nt_input_offset = raw_offset;
+	nt_input_eof = 0;
+}
+
+int nt_trfile_read( void* ptr, unsigned int size ) {
+	char strerr[180];
+	char unused[BZ_MAX_UNUSED];
+	char* dst = (char*) ptr;
+	unsigned int total = 0;
+	int bzerr;
+	if( nt_input_map != NULL ) {
+		if( nt_input_offset < nt_native->trheader_length ) {
+			total = nt_native->trheader_length - nt_input_offset;
+			if( total > size ) {
+				total = size;
+			}
+			memcpy( dst, nt_input_map + nt_native->trheader_offset + nt_input_offset, total );
+		}
+		nt_input_offset += total;
+		return total;
+	}
+	while( total < size && !nt_input_eof ) {
+		int n = BZ2_bzRead( &bzerr, nt_input_bzfile, dst + total, size - total );
+		if( bzerr != BZ_OK && bzerr != BZ_STREAM_END ) {
+			sprintf( strerr, "failed to decompress trace file: bzerror = %d", bzerr );
+			nt_error( strerr );
+		}
+		total += n;
+		if( bzerr == BZ_STREAM_END ) {
+			// Indexed traces are a series of concatenated streams, carry the
+			// bytes the decoder read past this one over to the next
+			void* tail;
+			int num_unused;
+			BZ2_bzReadGetUnused( &bzerr, nt_input_bzfile, &tail, &num_unused );
+			memcpy( unused, tail, num_unused );
+			BZ2_bzReadClose( &bzerr, nt_input_bzfile );
+			nt_input_bzfile = NULL;
+			if( num_unused == 0 ) {
+				int c = fgetc( nt_input_tracefile );
+				if( c == EOF ) {
+					nt_input_eof = 1;
+					break;
+				}
+				ungetc( c, nt_input_tracefile );
+			}
+			nt_input_bzfile = BZ2_bzReadOpen( &bzerr, nt_input_tracefile, 0, 0, unused, num_unused );
+			if( bzerr != BZ_OK ) {
+				nt_error( "failed to open bzip2 stream in trace file" );
+			}
+		}
+	}
+	nt_input_offset += total;
+	return total;
+}
+
+void nt_trfile_seek( unsigned long long int raw_offset ) {
+	unsigned long long int start_raw = 0;
+	unsigned long long int start_file = 0;
+	unsigned int i;
+	// Closest indexed stream that starts at or before the target
+	for( i = 0; i < nt_input_index_size && nt_input_index[i].raw_offset <= raw_offset; i++ ) {
+		start_raw = nt_input_index[i].raw_offset;
+		start_file = nt_input_index[i].file_offset;
+	}
+	// Only restart the decoder when going backwards or when a stream
+	// boundary lets us jump past data we would otherwise decompress
+	if( raw_offset < nt_input_offset || start_raw > nt_input_offset ) {
+		nt_trfile_reopen( start_raw, start_file );
+	}
+	unsigned int read_length = 65536;
+	char* buffer = (char*) nt_checked_malloc( read_length );
+	while( nt_input_offset < raw_offset ) {
+		unsigned long long int remaining = raw_offset - nt_input_offset;
+		unsigned int chunk = ( remaining > read_length ) ? read_length : (unsigned int) remaining;
+		if( nt_trfile_read( buffer, chunk ) < chunk ) {
+			nt_error( "failed to seek region: unexpected end of trace file" );
+		}
+	}
+	free( buffer );
+}
+
 nt_packet_t* nt_read_packet( void ) {
+	nt_packet_t* to_return = NULL;
+	if( nt_input_tracefile != NULL ) {
+		to_return = nt_next_packet();
+		if( to_return != NULL ) {
+			nt_track_packet( to_return );
+		}
+	} else {
+		nt_error( "must open trace file with nt_open_trfile before reading" );
+	}
+	return to_return;
+}
+
+// Like nt_read_packet() but never waits for the prefetch thread: returns 0
+// and leaves *packet alone when the next packet is not decoded yet
+int nt_try_read_packet( nt_packet_t** packet ) {
+	if( nt_input_tracefile == NULL ) {
+		nt_error( "must open trace file with nt_open_trfile before reading" );
+	}
+	nt_packet_t* to_return;
+	if( nt_input_pending != NULL ) {
+		to_return = nt_input_pending;
+		nt_input_pending = NULL;
+	} else if( nt_prefetch_on ) {
+		if( !nt_prefetch_try_pop( &to_return ) ) {
+			return 0;
+		}
+	} else {
+		to_return = nt_decode_packet();
+		nt_input_position = nt_decode_position();
+	}
+	if( to_return != NULL ) {
+		nt_track_packet( to_return );
+	}
+	*packet = to_return;
+	return 1;
+}
+
+nt_packet_t* nt_next_packet( void ) {
+	nt_packet_t* to_return;
+	if( nt_input_pending != NULL ) {
+		// Left over from a cycle seek on a compressed trace
+		to_return = nt_input_pending;
+		nt_input_pending = NULL;
+	} else if( nt_prefetch_on ) {
+		while( !nt_prefetch_try_pop( &to_return ) ) {
+			sched_yield();
+		}
+	} else {
+		to_return = nt_decode_packet();
+		nt_input_position = nt_decode_position();
+	}
+	return to_return;
+}
+
+unsigned long long int nt_decode_position( void ) {
+	return ( nt_input_map != NULL ) ? nt_native_next : nt_input_offset;
+}
+
+unsigned long long int nt_tell( void ) {
+	if( nt_input_tracefile == NULL ) {
+		nt_error( "must open trace file with nt_open_trfile before telling" );
+	}
+	return nt_input_position;
+}
+
+// Resumes reading at a position returned by nt_tell(). Unlike the region and
+// cycle seeks this leaves the dependency table alone: it is meant for restoring
+// a saved reader together with the dependencies that were live at the time
+void nt_seek_position( unsigned long long int position ) {
+	if( nt_input_tracefile == NULL ) {
+		nt_error( "must open trace file with nt_open_trfile before seeking" );
+	}
+	int prefetch = nt_prefetch_on;
+	if( prefetch ) {
+		nt_stop_prefetch();
+	}
+	if( nt_input_pending != NULL ) {
+		nt_packet_free( nt_input_pending );
+		nt_input_pending = NULL;
+	}
+	if( nt_input_map != NULL ) {
+		if( position > nt_native->num_packets ) {
+			nt_error( "invalid position for native trace file" );
+		}
+		nt_native_next = position;
+	} else {
+		nt_trfile_seek( position );
+	}
+	nt_input_position = position;
+	if( prefetch ) {
+		nt_init_prefetch( nt_prefetch_depth );
+	}
+}
+
+nt_packet_t* nt_decode_packet( void ) {
 
 	#pragma pack(push,1)
 	struct nt_packet_pack {
@@ -227,76 +527,223 @@ nt_packet_t* nt_read_packet( void ) {
 	#pragma pack(pop)
 
 	int err = 0;
-	unsigned int i;
 	char strerr[180];
-	nt_packet_t* to_return = NULL;
-	if( nt_input_tracefile != NULL ) {
-		to_return = nt_packet_malloc();
-		if( (err = fread( to_return, 1, sizeof(struct nt_packet_pack), nt_input_tracefile )) < 0 ) {
-			sprintf( strerr, "failed to read packet: err = %d", err );
+	if( nt_input_map != NULL ) {
+		return nt_decode_native_packet();
+	}
+	nt_packet_t* to_return = nt_packet_malloc();
+	if( (err = nt_trfile_read( to_return, sizeof(struct nt_packet_pack) )) < 0 ) {
+		sprintf( strerr, "failed to read packet: err = %d", err );
+		nt_error( strerr );
+	}
+	if( err > 0 && err < sizeof(struct nt_packet_pack) ) {
+		// Bad packet - end of file
+		nt_error( "unexpectedly reached end of trace file - perhaps corrupt" );
+	} else if( err == 0 ) {
+		// End of file
+		nt_pool_free( &nt_packet_pool, to_return );
+		return NULL;
+	}
+	if( to_return->num_deps == 0 ) {
+		to_return->deps = NULL;
+	} else {
+		to_return->deps = nt_dependency_malloc( to_return->num_deps );
+		if( (err = nt_trfile_read( to_return->deps, to_return->num_deps * sizeof(nt_dependency_t) )) < to_return->num_deps * sizeof(nt_dependency_t) ) {
+			sprintf( strerr, "failed to read dependencies: err = %d", err );
 			nt_error( strerr );
 		}
-		if( err > 0 && err < sizeof(struct nt_packet_pack) ) {
-			// Bad packet - end of file
-			nt_error( "unexpectedly reached end of trace file - perhaps corrupt" );
-		} else if( err == 0 ) {
-			// End of file
-			free( to_return );
-			to_return = NULL;
-			return to_return;
-		}
-		if( !nt_dependencies_off ) {
-			// Track dependencies: add to_return to dependencies array
-			nt_dep_ref_node_t* node_ptr = nt_get_dependency_node( to_return->id );
+	}
+	return to_return;
+}
+
+nt_packet_t* nt_decode_native_packet( void ) {
+	if( nt_native_next >= nt_native->num_packets ) {
+		return NULL;
+	}
+	nt_native_packet_t* record = &nt_native_packets[nt_native_next++];
+	nt_packet_t* to_return = nt_packet_malloc();
+	to_return->cycle = record->cycle;
+	to_return->id = record->id;
+	to_return->addr = record->addr;
+	to_return->type = record->type;
+	to_return->src = record->src;
+	to_return->dst = record->dst;
+	to_return->node_types = record->node_types;
+	to_return->num_deps = record->num_deps;
+	// Dependencies are used in place, nt_packet_free() knows not to free them
+	to_return->deps = ( record->num_deps > 0 ) ? nt_native_deps + record->dep_offset : NULL;
+	return to_return;
+}
+
+void nt_seek_cycle( unsigned long long int cycle ) {
+	if( nt_input_tracefile == NULL ) {
+		nt_error( "must open trace file with nt_open_trfile before seeking" );
+	}
+	nt_delete_all_dependencies();
+	if( nt_input_map == NULL ) {
+		// Compressed traces have no cycle index: scan forward from the
+		// current position and keep the first packet at or past the cycle
+		nt_packet_t* packet;
+		while( ( packet = nt_next_packet() ) != NULL && packet->cycle < cycle ) {
+			nt_packet_free( packet );
+		}
+		nt_input_pending = packet;
+		if( nt_self_throttling ) {
+			nt_prime_self_throttle();
+		}
+		return;
+	}
+	int prefetch = nt_prefetch_on;
+	if( prefetch ) {
+		nt_stop_prefetch();
+	}
+	unsigned long long int* cycles = (unsigned long long int*) ( nt_input_map + nt_native->cycles_offset );
+	unsigned long long int bucket = cycle / nt_native->cycle_step;
+	if( bucket >= nt_native->num_cycle_buckets ) {
+		nt_native_next = nt_native->num_packets;
+	} else {
+		nt_native_next = cycles[bucket];
+		while( nt_native_next < nt_native->num_packets && nt_native_packets[nt_native_next].cycle < cycle ) {
+			nt_native_next++;
+		}
+	}
+	nt_input_position = nt_native_next;
+	if( prefetch ) {
+		nt_init_prefetch( nt_prefetch_depth );
+	}
+	if( nt_self_throttling ) {
+		nt_prime_self_throttle();
+	}
+}
+
+void nt_track_packet( nt_packet_t* packet ) {
+	unsigned int i;
+	if( !nt_dependencies_off ) {
+		// Track dependencies: add packet to dependencies array
+		nt_dep_ref_node_t* node_ptr = nt_get_dependency_node( packet->id );
+		if( node_ptr == NULL ) {
+			node_ptr = nt_add_dependency_node( packet->id );
+		}
+		node_ptr->node_packet = packet;
+		// Track dependencies: add packet downward dependencies to array
+		for( i = 0; i < packet->num_deps; i++ ) {
+			unsigned int dep_id = packet->deps[i];
+			node_ptr = nt_get_dependency_node( dep_id );
 			if( node_ptr == NULL ) {
-				node_ptr = nt_add_dependency_node( to_return->id );
+				node_ptr = nt_add_dependency_node( dep_id );
 			}
-			node_ptr->node_packet = to_return;
+			node_ptr->ref_count++;
 		}
-		nt_num_active_packets++;
-		nt_latest_active_packet_cycle = to_return->cycle;
-		if( to_return->num_deps == 0 ) {
-			to_return->deps = NULL;
-		} else {
-			to_return->deps = nt_dependency_malloc( to_return->num_deps );
-			if( (err = fread( to_return->deps, sizeof(nt_dependency_t), to_return->num_deps, nt_input_tracefile )) < 0 ) {
-				sprintf( strerr, "failed to read dependencies: err = %d", err );
-				nt_error( strerr );
-			}
-			if( !nt_dependencies_off ) {
-				// Track dependencies: add to_return downward dependencies to array
-				for( i = 0; i < to_return->num_deps; i++ ) {
-					unsigned int dep_id = to_return->deps[i];
-					nt_dep_ref_node_t* node_ptr = nt_get_dependency_node( dep_id );
-					if( node_ptr == NULL ) {
-						node_ptr = nt_add_dependency_node( dep_id );
-					}
-					node_ptr->ref_count++;
-				}
+	}
+	nt_num_active_packets++;
+	nt_latest_active_packet_cycle = packet->cycle;
+}
+
+void nt_init_prefetch( unsigned int depth ) {
+	if( nt_input_tracefile == NULL ) {
+		nt_error( "must open trace file with nt_open_trfile before prefetching" );
+	}
+	if( depth == 0 ) {
+		nt_error( "prefetch depth must be greater than zero" );
+	}
+	if( nt_prefetch_on ) {
+		nt_stop_prefetch();
+	}
+	nt_prefetch_depth = depth;
+	nt_prefetch_ring = (nt_packet_t**) nt_checked_malloc( depth * sizeof(nt_packet_t*) );
+	nt_prefetch_positions = (unsigned long long int*) nt_checked_malloc( depth * sizeof(unsigned long long int) );
+	atomic_init( &nt_prefetch_head, 0 );
+	atomic_init( &nt_prefetch_tail, 0 );
+	atomic_init( &nt_prefetch_eof, 0 );
+	atomic_init( &nt_prefetch_stop, 0 );
+	if( pthread_create( &nt_prefetch_thread, NULL, nt_prefetch_main, NULL ) != 0 ) {
+		nt_error( "failed to start trace prefetch thread" );
+	}
+	nt_prefetch_on = 1;
+}
+
+void nt_stop_prefetch( void ) {
+	if( nt_prefetch_on ) {
+		atomic_store_explicit( &nt_prefetch_stop, 1, memory_order_relaxed );
+		pthread_join( nt_prefetch_thread, NULL );
+		// Packets still in the ring were never handed to the dependency tracker
+		unsigned long long int head = atomic_load_explicit( &nt_prefetch_head, memory_order_relaxed );
+		unsigned long long int tail = atomic_load_explicit( &nt_prefetch_tail, memory_order_relaxed );
+		for( ; head != tail; head++ ) {
+			nt_packet_free( nt_prefetch_ring[head % nt_prefetch_depth] );
+		}
+		free( nt_prefetch_ring );
+		nt_prefetch_ring = NULL;
+		free( nt_prefetch_positions );
+		nt_prefetch_positions = NULL;
+		nt_prefetch_on = 0;
+	}
+}
+
+void* nt_prefetch_main( void* arg ) {
+	unsigned long long int tail = atomic_load_explicit( &nt_prefetch_tail, memory_order_relaxed );
+	while( !atomic_load_explicit( &nt_prefetch_stop, memory_order_relaxed ) ) {
+		// Decode before claiming a slot, this is the work we are taking off the simulator
+		nt_packet_t* packet = nt_decode_packet();
+		unsigned long long int position = nt_decode_position();
+		if( packet == NULL ) {
+			atomic_store_explicit( &nt_prefetch_eof, 1, memory_order_release );
+			break;
+		}
+		// Only this thread waits: the simulator side never does
+		while( tail - atomic_load_explicit( &nt_prefetch_head, memory_order_acquire ) == nt_prefetch_depth ) {
+			if( atomic_load_explicit( &nt_prefetch_stop, memory_order_relaxed ) ) {
+				nt_packet_free( packet );
+				return NULL;
 			}
+			sched_yield();
 		}
-	} else {
-		nt_error( "must open trace file with nt_open_trfile before reading" );
+		nt_prefetch_ring[tail % nt_prefetch_depth] = packet;
+		nt_prefetch_positions[tail % nt_prefetch_depth] = position;
+		tail++;
+		atomic_store_explicit( &nt_prefetch_tail, tail, memory_order_release );
 	}
-	return to_return;
+	return NULL;
+}
+
+// Takes the next decoded packet without waiting. Returns 0 while the prefetch
+// thread is behind; at the end of the trace returns 1 with a NULL packet
+int nt_prefetch_try_pop( nt_packet_t** packet ) {
+	unsigned long long int head = atomic_load_explicit( &nt_prefetch_head, memory_order_relaxed );
+	if( head == atomic_load_explicit( &nt_prefetch_tail, memory_order_acquire ) ) {
+		// eof is set after the last slot is published, so check it before
+		// taking the empty ring for the end of the trace
+		if( !atomic_load_explicit( &nt_prefetch_eof, memory_order_acquire ) ||
+				head != atomic_load_explicit( &nt_prefetch_tail, memory_order_acquire ) ) {
+			return 0;
+		}
+		*packet = NULL;
+		return 1;
+	}
+	*packet = nt_prefetch_ring[head % nt_prefetch_depth];
+	nt_input_position = nt_prefetch_positions[head % nt_prefetch_depth];
+	atomic_store_explicit( &nt_prefetch_head, head + 1, memory_order_release );
+	return 1;
 }
 
 nt_dep_ref_node_t* nt_add_dependency_node( unsigned int packet_id ) {
 	if( nt_dependency_array != NULL ) {
-		unsigned int index = packet_id % NT_DEPENDENCY_ARRAY_SIZE;
-		nt_dep_ref_node_t* dep_ptr = nt_dependency_array[index];
-		if( dep_ptr == NULL ) {
-			nt_dependency_array[index] = nt_checked_malloc( sizeof(nt_dep_ref_node_t) );
-			dep_ptr = nt_dependency_array[index];
-		} else {
-			for( ; dep_ptr->next_node != NULL; dep_ptr = dep_ptr->next_node );
-			dep_ptr->next_node = nt_checked_malloc( sizeof(nt_dep_ref_node_t) );
-			dep_ptr = dep_ptr->next_node;
+		// Keep the table at most half full so probe sequences stay short
+		if( 2 * ( nt_dependency_count + 1 ) > nt_dependency_array_size ) {
+			nt_grow_dependency_array();
+		}
+		unsigned int mask = nt_dependency_array_size - 1;
+		unsigned int index = nt_dependency_slot( packet_id );
+		while( nt_dependency_array[index] != NULL ) {
+			index = ( index + 1 ) & mask;
 		}
+		nt_dep_ref_node_t* dep_ptr = nt_pool_alloc( &nt_dependency_pool );
 		dep_ptr->node_packet = NULL;
 		dep_ptr->packet_id = packet_id;
 		dep_ptr->ref_count = 0;
 		dep_ptr->next_node = NULL;
+		nt_dependency_array[index] = dep_ptr;
+		nt_dependency_count++;
 		return dep_ptr;
 	} else {
 		nt_error( "dependency array NULL on node addition" );
@@ -304,6 +751,33 @@ nt_dep_ref_node_t* nt_add_dependency_node( unsigned int packet_id ) {
 	return NULL;
 }
 
+unsigned int nt_dependency_slot( unsigned int packet_id ) {
+	// Packet ids are mostly sequential, mix them before masking
+	unsigned int hash = packet_id * 2654435761u;
+	hash ^= hash >> 16;
+	return hash & ( nt_dependency_array_size - 1 );
+}
+
+void nt_grow_dependency_array( void ) {
+	unsigned int i;
+	unsigned int old_size = nt_dependency_array_size;
+	nt_dep_ref_node_t** old_array = nt_dependency_array;
+	nt_dependency_array_size = 2 * old_size;
+	nt_dependency_array = nt_checked_malloc( sizeof(nt_dep_ref_node_t*) * nt_dependency_array_size );
+	memset( nt_dependency_array, 0, sizeof(nt_dep_ref_node_t*) * nt_dependency_array_size );
+	unsigned int mask = nt_dependency_array_size - 1;
+	for( i = 0; i < old_size; i++ ) {
+		if( old_array[i] != NULL ) {
+			unsigned int index = nt_dependency_slot( old_array[i]->packet_id );
+			while( nt_dependency_array[index] != NULL ) {
+				index = ( index + 1 ) & mask;
+			}
+			nt_dependency_array[index] = old_array[i];
+		}
+	}
+	free( old_array );
+}
+
 void nt_read_ahead( unsigned long long int current_cycle ) {
 	unsigned long long int read_to_cycle = current_cycle + NT_READ_AHEAD;
 	if( read_to_cycle < current_cycle ) {
@@ -330,27 +804,31 @@ void nt_read_ahead( unsigned long long int current_cycle ) {
 
 nt_packet_t* nt_remove_dependency_node( unsigned int packet_id ) {
 	if( nt_dependency_array != NULL ) {
-		unsigned int index = packet_id % NT_DEPENDENCY_ARRAY_SIZE;
+		unsigned int mask = nt_dependency_array_size - 1;
+		unsigned int index = nt_dependency_slot( packet_id );
+		for( ; nt_dependency_array[index] != NULL; index = ( index + 1 ) & mask ) {
+			if( nt_dependency_array[index]->packet_id == packet_id ) break;
+		}
 		nt_dep_ref_node_t* dep_ptr = nt_dependency_array[index];
 		if( dep_ptr == NULL ) {
 			return NULL;
-		} else {
-			nt_dep_ref_node_t* prev_ptr = NULL;
-			for( ; dep_ptr != NULL; prev_ptr = dep_ptr, dep_ptr = dep_ptr->next_node ) {
-				if( dep_ptr->packet_id == packet_id ) break;
-			}
-			if( dep_ptr == NULL ) {
-				return NULL;
-			}
-			if( prev_ptr == NULL ) {
-				nt_dependency_array[index] = dep_ptr->next_node;
-			} else {
-				prev_ptr->next_node = dep_ptr->next_node;
+		}
+		// Backward shift deletion: pull later entries of the probe run into
+		// the hole so lookups never need tombstones
+		unsigned int hole = index;
+		unsigned int next = ( hole + 1 ) & mask;
+		for( ; nt_dependency_array[next] != NULL; next = ( next + 1 ) & mask ) {
+			unsigned int home = nt_dependency_slot( nt_dependency_array[next]->packet_id );
+			if( ( ( next - home ) & mask ) >= ( ( next - hole ) & mask ) ) {
+				nt_dependency_array[hole] = nt_dependency_array[next];
+				hole = next;
 			}
-			nt_packet_t* packet = dep_ptr->node_packet;
-			free( dep_ptr );
-			return packet;
 		}
+		nt_dependency_array[hole] = NULL;
+		nt_dependency_count--;
+		nt_packet_t* packet = dep_ptr->node_packet;
+		nt_pool_free( &nt_dependency_pool, dep_ptr );
+		return packet;
 	} else {
 		nt_error( "dependency array NULL on node remove" );
 	}
@@ -359,9 +837,10 @@ nt_packet_t* nt_remove_dependency_node( unsigned int packet_id ) {
 
 nt_dep_ref_node_t* nt_get_dependency_node( unsigned int packet_id ) {
 	if( nt_dependency_array != NULL ) {
-		unsigned int index = packet_id % NT_DEPENDENCY_ARRAY_SIZE;
+		unsigned int mask = nt_dependency_array_size - 1;
+		unsigned int index = nt_dependency_slot( packet_id );
 		nt_dep_ref_node_t* dep_ptr;
-		for( dep_ptr = nt_dependency_array[index]; dep_ptr != NULL; dep_ptr = dep_ptr->next_node ) {
+		for( ; ( dep_ptr = nt_dependency_array[index] ) != NULL; index = ( index + 1 ) & mask ) {
 			if( dep_ptr->packet_id == packet_id ) break;
 		}
 		return dep_ptr;
@@ -448,7 +927,7 @@ void nt_init_self_throttling() {
 }
 
 nt_packet_list_t* nt_get_cleared_packets_list() {
-	if( !nt_primed_self_throttle ) {
+	if( nt_self_throttling && !nt_primed_self_throttle ) {
 		nt_prime_self_throttle();
 	}
 	return nt_cleared_packets_list;
@@ -464,7 +943,7 @@ void nt_prime_self_throttle() {
 }
 
 void nt_add_cleared_packet_to_list( nt_packet_t* packet ) {
-	nt_packet_list_t* new_node = nt_checked_malloc( sizeof(nt_packet_list_t) );
+	nt_packet_list_t* new_node = nt_pool_alloc( &nt_packet_list_pool );
 	new_node->node_packet = packet;
 	new_node->next = NULL;
 	if( nt_cleared_packets_list == NULL ) {
@@ -479,33 +958,52 @@ void nt_empty_cleared_packets_list() {
 	while( nt_cleared_packets_list != NULL ) {
 		nt_packet_list_t* temp = nt_cleared_packets_list;
 		nt_cleared_packets_list = nt_cleared_packets_list->next;
-		free( temp );
+		nt_pool_free( &nt_packet_list_pool, temp );
 	}
 	nt_cleared_packets_list = nt_cleared_packets_list_tail = NULL;
 }
 
 void nt_close_trfile() {
 	if( nt_input_tracefile != NULL ) {
-		pclose( nt_input_tracefile );
+		int bzerr;
+		nt_stop_prefetch();
+		if( nt_input_bzfile != NULL ) {
+			BZ2_bzReadClose( &bzerr, nt_input_bzfile );
+			nt_input_bzfile = NULL;
+		}
+		if( nt_input_pending != NULL ) {
+			nt_packet_free( nt_input_pending );
+			nt_input_pending = NULL;
+		}
+		if( nt_input_map != NULL ) {
+			munmap( nt_input_map, nt_input_map_size );
+			nt_input_map = NULL;
+			nt_native = NULL;
+		}
+		fclose( nt_input_tracefile );
 		nt_input_tracefile = NULL;
 		nt_free_trheader( nt_input_trheader );
-		if( nt_input_popencmd != NULL ) {
-			free( nt_input_popencmd );
+		if( nt_input_index != NULL ) {
+			free( nt_input_index );
 		}
-		nt_input_popencmd = NULL;
+		nt_input_index = NULL;
+		nt_input_index_size = 0;
 		nt_delete_all_dependencies();
 		free(nt_dependency_array);
 		nt_dependency_array = NULL;
+		nt_pool_destroy( &nt_dependency_pool );
 	}
 }
 
 void nt_delete_all_dependencies() {
-	int i;
-	for( i = 0; i < NT_DEPENDENCY_ARRAY_SIZE; i++ ) {
-		while( nt_dependency_array[i] != NULL ) {
-			nt_remove_dependency_node( nt_dependency_array[i]->packet_id );
+	unsigned int i;
+	for( i = 0; i < nt_dependency_array_size; i++ ) {
+		if( nt_dependency_array[i] != NULL ) {
+			nt_pool_free( &nt_dependency_pool, nt_dependency_array[i] );
+			nt_dependency_array[i] = NULL;
 		}
 	}
+	nt_dependency_count = 0;
 }
 
 void nt_print_header( nt_header_t* header ) {
@@ -563,15 +1061,84 @@ float nt_get_trversion() {
 }
 
 nt_packet_t* nt_packet_malloc() {
-	// TODO: v1.1?
-	// Allocate large array (1+ pages) to reduce # system calls
-	return (nt_packet_t*) nt_checked_malloc( sizeof(nt_packet_t) );
+	return (nt_packet_t*) nt_pool_alloc( &nt_packet_pool );
 }
 
 nt_dependency_t* nt_dependency_malloc( unsigned char num_deps ) {
-	// TODO: v1.1?
-	// Allocate large array (1+ pages) to reduce # system calls
-	return (nt_dependency_t*) nt_checked_malloc( num_deps * sizeof(nt_dependency_t) );
+	return (nt_dependency_t*) nt_pool_alloc( &nt_dependency_array_pools[nt_dependency_class( num_deps )] );
+}
+
+void nt_dependency_free( nt_dependency_t* deps, unsigned char num_deps ) {
+	nt_pool_free( &nt_dependency_array_pools[nt_dependency_class( num_deps )], deps );
+}
+
+unsigned int nt_dependency_class( unsigned char num_deps ) {
+	// Smallest power of two holding num_deps, starting from 2
+	unsigned int i = 0;
+	while( ( 2u << i ) < num_deps ) {
+		i++;
+	}
+	return i;
+}
+
+void nt_pool_init( nt_pool_t* pool, size_t object_size, unsigned int slab_objects ) {
+	// Free objects hold the free list link, so round up to a pointer
+	if( object_size < sizeof(void*) ) {
+		object_size = sizeof(void*);
+	}
+	pool->object_size = ( object_size + sizeof(void*) - 1 ) & ~( sizeof(void*) - 1 );
+	pool->slab_objects = slab_objects;
+	pool->shared = 0;
+	pool->free_list = NULL;
+	pool->slabs = NULL;
+	pthread_mutex_init( &pool->lock, NULL );
+}
+
+void* nt_pool_alloc( nt_pool_t* pool ) {
+	if( pool->shared ) {
+		pthread_mutex_lock( &pool->lock );
+	}
+	if( pool->free_list == NULL ) {
+		// First word of each slab chains the slabs for nt_pool_destroy
+		unsigned int i;
+		char* slab = (char*) nt_checked_malloc( sizeof(void*) + pool->slab_objects * pool->object_size );
+		*(void**) slab = pool->slabs;
+		pool->slabs = slab;
+		char* object = slab + sizeof(void*);
+		for( i = 0; i < pool->slab_objects; i++, object += pool->object_size ) {
+			*(void**) object = pool->free_list;
+			pool->free_list = object;
+		}
+	}
+	void* to_return = pool->free_list;
+	pool->free_list = *(void**) to_return;
+	if( pool->shared ) {
+		pthread_mutex_unlock( &pool->lock );
+	}
+	return to_return;
+}
+
+void nt_pool_free( nt_pool_t* pool, void* object ) {
+	if( object != NULL ) {
+		if( pool->shared ) {
+			pthread_mutex_lock( &pool->lock );
+		}
+		*(void**) object = pool->free_list;
+		pool->free_list = object;
+		if( pool->shared ) {
+			pthread_mutex_unlock( &pool->lock );
+		}
+	}
+}
+
+void nt_pool_destroy( nt_pool_t* pool ) {
+	while( pool->slabs != NULL ) {
+		void* next = *(void**) pool->slabs;
+		free( pool->slabs );
+		pool->slabs = next;
+	}
+	pool->free_list = NULL;
+	pthread_mutex_destroy( &pool->lock );
 }
 
 int nt_get_src_type( nt_packet_t* packet ) {
@@ -621,10 +1188,13 @@ nt_packet_t* nt_packet_copy( nt_packet_t* packet ) {
 
 void nt_packet_free( nt_packet_t* packet ) {
 	if( packet != NULL ) {
-		if( packet->num_deps > 0 ) {
-			free( packet->deps );
+		// Native traces hand out dependencies straight from the mapping
+		int mapped = nt_input_map != NULL && (char*) packet->deps >= nt_input_map &&
+				(char*) packet->deps < nt_input_map + nt_input_map_size;
+		if( packet->num_deps > 0 && !mapped ) {
+			nt_dependency_free( packet->deps, packet->num_deps );
 		}
-		free( packet );
+		nt_pool_free( &nt_packet_pool, packet );
 	}
 }
 
@@ -33,12 +33,23 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <bzlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sched.h>
+#ifndef __cplusplus
+#include <stdatomic.h>
+#endif
 
 // Macro Definitions
 //#define DEBUG_ON
 #define NT_MAGIC 0x484A5455
 #define NT_BMARK_NAME_LENGTH 30
-#define NT_DEPENDENCY_ARRAY_SIZE 200
+#define NT_DEPENDENCY_ARRAY_SIZE 4096	// Initial slots, must be a power of two
+#define NT_POOL_SLAB_BYTES 65536
+#define NT_DEPENDENCY_CLASSES 8		// Pooled dependency arrays of 2, 4, ... 256 entries
+#define NT_POOL_INITIALIZER(size,shared) { size, NT_POOL_SLAB_BYTES / (size), shared, NULL, NULL, PTHREAD_MUTEX_INITIALIZER }
 #define nt_checked_malloc(x) _nt_checked_malloc(x,__FILE__,__LINE__)
 #define nt_error(x) _nt_error(x,__FILE__,__LINE__)
 #define NT_NUM_PACKET_TYPES	31
@@ -48,6 +59,12 @@
 #define NT_NODE_TYPE_L2		2
 #define NT_NODE_TYPE_MC		3
 #define NT_READ_AHEAD		1000000
+#define NT_INDEX_MAGIC		0x4E544958
+#define NT_INDEX_VERSION	2
+#define NT_INDEX_SUFFIX		".idx"
+#define NT_NATIVE_MAGIC		0x4E544E56
+#define NT_NATIVE_VERSION	1
+#define NT_NATIVE_CYCLE_STEP	1024
 
 // Type Declaration
 typedef unsigned int nt_dependency_t;
@@ -56,6 +73,12 @@ typedef struct nt_regionhead nt_regionhead_t;
 typedef struct nt_packet nt_packet_t;
 typedef struct nt_dep_ref_node nt_dep_ref_node_t;
 typedef struct nt_packet_list nt_packet_list_t;
+typedef struct nt_pool nt_pool_t;
+typedef struct nt_index_header nt_index_header_t;
+typedef struct nt_index_entry nt_index_entry_t;
+typedef struct nt_native_header nt_native_header_t;
+typedef struct nt_native_packet nt_native_packet_t;
+typedef struct nt_native_region nt_native_region_t;
 
 struct nt_header {
 	unsigned int nt_magic;
@@ -92,7 +115,18 @@ struct nt_dep_ref_node {
 	nt_packet_t* node_packet;
 	unsigned int packet_id;
 	unsigned int ref_count;
-	nt_dep_ref_node_t* next_node;
+	nt_dep_ref_node_t* next_node;	// Free list link while in the pool
+};
+
+// Fixed-size object allocator: objects are carved out of large slabs and
+// recycled through a free list instead of going back to malloc
+struct nt_pool {
+	size_t object_size;
+	unsigned int slab_objects;
+	int shared;				// Also used by the prefetch thread, take the lock
+	void* free_list;
+	void* slabs;
+	pthread_mutex_t lock;
 };
 
 struct nt_packet_list {
@@ -100,9 +134,76 @@ struct nt_packet_list {
 	nt_packet_list_t* next;
 };
 
+// Sidecar index header: the size and mtime of the trace the index was built
+// for, so an index left next to a rewritten trace is not trusted
+struct nt_index_header {
+	unsigned int magic;
+	unsigned int version;
+	unsigned int count;
+	unsigned int reserved;
+	unsigned long long int source_size;
+	long long int source_mtime;
+};
+
+// Sidecar index entry: a bzip2 stream starting at file_offset in the
+// compressed trace decompresses to the trace bytes from raw_offset on
+struct nt_index_entry {
+	unsigned long long int raw_offset;
+	unsigned long long int file_offset;
+};
+
+// Native trace format: uncompressed, fixed-size records meant to be mmap'ed.
+// All offsets are in bytes from the start of the file. The original netrace
+// header is kept verbatim so nt_get_trheader() behaves as for .tra.bz2.
+struct nt_native_header {
+	unsigned int magic;
+	unsigned int version;
+	unsigned long long int num_packets;
+	unsigned long long int num_deps;
+	unsigned long long int trheader_offset;
+	unsigned long long int trheader_length;
+	unsigned long long int packets_offset;		// nt_native_packet_t[num_packets]
+	unsigned long long int deps_offset;			// nt_dependency_t[num_deps]
+	unsigned long long int regions_offset;		// nt_native_region_t[num_regions]
+	unsigned long long int cycles_offset;		// first packet at or after each cycle_step boundary
+	unsigned long long int num_cycle_buckets;
+	unsigned int num_regions;
+	unsigned int cycle_step;
+};
+
+struct nt_native_packet {
+	unsigned long long int cycle;
+	unsigned int id;
+	unsigned int addr;
+	unsigned long long int dep_offset;			// index of the first dependency in the deps table
+	unsigned char type;
+	unsigned char src;
+	unsigned char dst;
+	unsigned char node_types;
+	unsigned char num_deps;
+	unsigned char pad[3];
+};
+
+struct nt_native_region {
+	unsigned long long int seek_offset;
+	unsigned long long int first_packet;
+};
+
 // Data Members
-extern char*				nt_input_popencmd;
 extern FILE*				nt_input_tracefile;
+extern BZFILE*				nt_input_bzfile;
+extern unsigned long long int nt_input_offset;
+extern int					nt_input_eof;
+extern nt_index_entry_t*	nt_input_index;
+extern unsigned int		nt_input_index_size;
+extern char*				nt_input_map;
+extern size_t				nt_input_map_size;
+extern nt_native_header_t*	nt_native;
+extern nt_native_packet_t*	nt_native_packets;
+extern nt_dependency_t*	nt_native_deps;
+extern unsigned long long int nt_native_next;
+extern nt_packet_t*		nt_input_pending;
+extern unsigned long long int nt_input_position;	// Where the packet after the last one handed out starts
 extern char*				nt_input_buffer;
 extern nt_header_t*		nt_input_trheader;
 extern int						nt_dependencies_off;
@@ -111,6 +212,12 @@ extern int					nt_primed_self_throttle;
 extern int					nt_done_reading;
 extern unsigned long long int nt_latest_active_packet_cycle;
 extern nt_dep_ref_node_t** nt_dependency_array;
+extern unsigned int		nt_dependency_array_size;
+extern unsigned int		nt_dependency_count;
+extern nt_pool_t			nt_dependency_pool;
+extern nt_pool_t			nt_packet_pool;
+extern nt_pool_t			nt_dependency_array_pools[NT_DEPENDENCY_CLASSES];
+extern nt_pool_t			nt_packet_list_pool;
 extern unsigned long long int nt_num_active_packets;
 extern const char* nt_packet_types[];
 extern int nt_packet_sizes[];
@@ -118,12 +225,24 @@ extern const char* nt_node_types[];
 extern nt_packet_list_t*	nt_cleared_packets_list;
 extern nt_packet_list_t*	nt_cleared_packets_list_tail;
 extern int nt_track_cleared_packets_list;
+extern int					nt_prefetch_on;
+extern unsigned int		nt_prefetch_depth;
+extern nt_packet_t**		nt_prefetch_ring;
+extern unsigned long long int* nt_prefetch_positions;
+extern pthread_t			nt_prefetch_thread;
+#ifndef __cplusplus
+extern atomic_ullong		nt_prefetch_head;
+extern atomic_ullong		nt_prefetch_tail;
+extern atomic_int			nt_prefetch_eof;
+extern atomic_int			nt_prefetch_stop;
+#endif
 
 // Interface Functions
 void			nt_open_trfile( const char* );
 void			nt_disable_dependencies( void );
 void			nt_seek_region( nt_regionhead_t* );
 nt_packet_t*	nt_read_packet( void );
+int				nt_try_read_packet( nt_packet_t** );
 int				nt_dependencies_cleared( nt_packet_t* );
 void			nt_clear_dependencies_free_packet( nt_packet_t* );
 void			nt_close_trfile( void );
@@ -131,6 +250,11 @@ void			nt_init_cleared_packets_list();
 void			nt_init_self_throttling();
 nt_packet_list_t*	nt_get_cleared_packets_list();
 void			nt_empty_cleared_packets_list();
+void			nt_init_prefetch( unsigned int );
+void			nt_stop_prefetch( void );
+void			nt_seek_cycle( unsigned long long int );
+unsigned long long int	nt_tell( void );
+void			nt_seek_position( unsigned long long int );
 
 // Utility Functions
 void			nt_print_trheader( void );
@@ -151,7 +275,15 @@ void				nt_free_trheader( nt_header_t* );
 int					nt_get_headersize( void );
 nt_packet_t*		nt_packet_malloc( void );
 nt_dependency_t*	nt_dependency_malloc( unsigned char );
+void				nt_dependency_free( nt_dependency_t*, unsigned char );
+unsigned int		nt_dependency_class( unsigned char );
 nt_dep_ref_node_t*	nt_get_dependency_node( unsigned int );
+unsigned int		nt_dependency_slot( unsigned int );
+void				nt_grow_dependency_array( void );
+void				nt_pool_init( nt_pool_t*, size_t, unsigned int );
+void*				nt_pool_alloc( nt_pool_t* );
+void				nt_pool_free( nt_pool_t*, void* );
+void				nt_pool_destroy( nt_pool_t* );
 nt_dep_ref_node_t*	nt_add_dependency_node( unsigned int );
 nt_packet_t*		nt_remove_dependency_node( unsigned int );
 void				nt_delete_all_dependencies( void );
@@ -160,6 +292,18 @@ void				nt_packet_free( nt_packet_t* );
 void				nt_read_ahead( unsigned long long int );
 void				nt_prime_self_throttle( void );
 void				nt_add_cleared_packet_to_list( nt_packet_t* );
+void				nt_load_index( const char* );
+void				nt_trfile_reopen( unsigned long long int, unsigned long long int );
+int					nt_trfile_read( void*, unsigned int );
+void				nt_trfile_seek( unsigned long long int );
+void				nt_map_native( void );
+unsigned long long int	nt_decode_position( void );
+nt_packet_t*		nt_decode_native_packet( void );
+nt_packet_t*		nt_decode_packet( void );
+void				nt_track_packet( nt_packet_t* );
+void*				nt_prefetch_main( void* );
+int					nt_prefetch_try_pop( nt_packet_t** );
+nt_packet_t*		nt_next_packet( void );
 void*				_nt_checked_malloc( size_t, char*, int ); // Use the macro defined above instead of this function
 void				_nt_error( const char*, char*, int ); // Use the macro defined above instead of this functio
 
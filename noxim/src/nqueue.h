@@ -11,87 +11,83 @@
 #ifndef NQUEUE_H_
 #define NQUEUE_H_
 
-#include <queue>
-#include <thread>
-#include <mutex>
-#include <condition_variable>
+#include <cassert>
+#include <cstddef>
 
 using namespace std;
 
+// FIFO for queues owned by one thread, i.e. everything touched from the
+// SystemC processes (inject_q, eject_q, noc_inject_q). No locks and never
+// blocks: the ring doubles when full, pop() must not be called when empty.
 template <typename T>
 class Queue
 {
  public:
 
+  Queue() : ring_(new T[INITIAL_CAPACITY]), mask_(INITIAL_CAPACITY - 1), head_(0), size_(0) {}
+  ~Queue() { delete[] ring_; }
+
   T pop()
   {
-    std::unique_lock<std::mutex> mlock(mutex_);
-    while (queue_.empty())
-    {
-      cond_.wait(mlock);
-    }
-    auto item = queue_.front();
-    queue_.pop();
-    mlock.unlock();
+    assert(size_ > 0);
+    T item = ring_[head_];
+    head_ = (head_ + 1) & mask_;
+    size_--;
     return item;
   }
+
   T front()
   {
-    std::unique_lock<std::mutex> mlock(mutex_);
-    if (queue_.empty())
+    if (size_ == 0)
     {
-      return NULL;
+      return T();
     }
-    auto item = queue_.front();
-    mlock.unlock();
-    return item;
+    return ring_[head_];
   }
 
-  void pop(T item)
+  void push(const T item)
   {
-    std::unique_lock<std::mutex> mlock(mutex_);
-    while (queue_.empty())
+    if (size_ > mask_)
     {
-      cond_.wait(mlock);
+      grow();
     }
-    item = queue_.front();
-    mlock.unlock();
-    queue_.pop();
-  }
-
-  void push(const T item)
-  {
-    std::unique_lock<std::mutex> mlock(mutex_);
-    queue_.push(item);
-    mlock.unlock();
-    cond_.notify_one();
-  }
-
-  void push(T** item)
-  {
-    std::unique_lock<std::mutex> mlock(mutex_);
-    queue_.push(std::move(item));
-    mlock.unlock();
-    cond_.notify_one();
+    ring_[(head_ + size_) & mask_] = item;
+    size_++;
   }
 
   bool is_empty()
   {
-	  if(queue_.empty())
-		  return true;
-	  else
-		  return false;
+	  return size_ == 0;
   }
   unsigned int get_size()
   {
-  	return queue_.size();
+  	return size_;
   }
 
  private:
-  std::queue<T> queue_;
-  std::mutex mutex_;
-  std::condition_variable cond_;
-};
+  static const unsigned int INITIAL_CAPACITY = 16;	// power of two
+
+  Queue(const Queue &);
+  Queue & operator=(const Queue &);
+
+  void grow()
+  {
+    unsigned int capacity = 2 * (mask_ + 1);
+    T* ring = new T[capacity];
+    for (unsigned int i = 0; i < size_; i++)
+    {
+      ring[i] = ring_[(head_ + i) & mask_];
+    }
+    delete[] ring_;
+    ring_ = ring;
+    mask_ = capacity - 1;
+    head_ = 0;
+  }
 
+  T* ring_;
+  unsigned int mask_;
+  unsigned int head_;
+  unsigned int size_;
+};
 
 #endif /* NQUEUE_H_ */
@@ -12,7 +12,15 @@ struct Router;
 class RoutingAlgorithm
 {
 	public:
-		virtual vector<int> route(Router * router, const RouteData & routeData) = 0;
+		// Admissible outputs, one DIRECTION_MASK() bit each
+		virtual unsigned int route(Router * router, const RouteData & routeData) = 0;
+
+		// Algorithms whose outputs only depend on the current node, the
+		// destination and the class of the source can be tabulated once
+		// per router (see Router::buildRouteTable())
+		virtual bool isTabulable() const { return false; }
+		virtual int sourceClasses() const { return 1; }
+		virtual int sourceClass(const RouteData & routeData) const { return 0; }
 };
 
 #endif
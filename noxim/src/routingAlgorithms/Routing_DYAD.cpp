@@ -3,7 +3,6 @@
 RoutingAlgorithmsRegister Routing_DYAD::routingAlgorithmsRegister("DYAD", getInstance());
 
 Routing_DYAD * Routing_DYAD::routing_DYAD = 0;
-RoutingAlgorithm * Routing_DYAD::odd_even = 0;
 
 Routing_DYAD * Routing_DYAD::getInstance() {
 	if ( routing_DYAD == 0 )
@@ -12,21 +11,25 @@ Routing_DYAD * Routing_DYAD::getInstance() {
     return routing_DYAD;
 }
 
-vector<int> Routing_DYAD::route(Router * router, const RouteData & routeData)
+unsigned int Routing_DYAD::route(Router * router, const RouteData & routeData)
 {
-    vector <int> directions;
+    unsigned int directions;
 
-    if (!odd_even)
-    {
-        odd_even = RoutingAlgorithms::get("ODD_EVEN");
-        
-        if (!odd_even)
-            assert(false);
-    }
+    // looked up on first use, by whichever thread routes first
+    static RoutingAlgorithm * odd_even = RoutingAlgorithms::get("ODD_EVEN");
+    assert(odd_even);
 
     directions = odd_even->route(router, routeData);
 
-    if (!router->inCongestion()) directions.resize(1);
+    // deterministic mode: the first of the odd-even candidates, i.e. west
+    // if admissible, the vertical direction otherwise
+    if (!router->inCongestion() && (directions & (directions - 1)))
+    {
+        if (directions & DIRECTION_MASK(DIRECTION_WEST))
+            directions = DIRECTION_MASK(DIRECTION_WEST);
+        else
+            directions &= DIRECTION_MASK(DIRECTION_NORTH) | DIRECTION_MASK(DIRECTION_SOUTH);
+    }
 
     return directions;
 }
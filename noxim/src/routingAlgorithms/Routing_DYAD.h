@@ -9,7 +9,7 @@ using namespace std;
 
 class Routing_DYAD : RoutingAlgorithm {
 	public:
-		vector<int> route(Router * router, const RouteData & routeData);
+		unsigned int route(Router * router, const RouteData & routeData);
 
 		static Routing_DYAD * getInstance();
 
@@ -19,7 +19,6 @@ class Routing_DYAD : RoutingAlgorithm {
 
 		static Routing_DYAD * routing_DYAD;
 		static RoutingAlgorithmsRegister routingAlgorithmsRegister;
-        static RoutingAlgorithm * odd_even;
 };
 
 #endif
@@ -12,11 +12,11 @@ Routing_NEGATIVE_FIRST * Routing_NEGATIVE_FIRST::getInstance() {
 	return routing_NEGATIVE_FIRST;
 }
 
-vector<int> Routing_NEGATIVE_FIRST::route(Router * router, const RouteData & routeData)
+unsigned int Routing_NEGATIVE_FIRST::route(Router * router, const RouteData & routeData)
 {
     Coord current = id2Coord(routeData.current_id);
     Coord destination = id2Coord(routeData.dst_id);
-    vector <int> directions;
+    unsigned int directions = 0;
     
     // Negative directions:
     // WEST (current x > dest x)
@@ -28,17 +28,17 @@ vector<int> Routing_NEGATIVE_FIRST::route(Router * router, const RouteData & rou
     if (destination.x < current.x || destination.y > current.y) // check negative directions first
     {
 	// note: one or both negative directions could be added
-	if (destination.x < current.x) directions.push_back(DIRECTION_WEST);
-	if (destination.y > current.y) directions.push_back(DIRECTION_SOUTH);
+	if (destination.x < current.x) directions |= DIRECTION_MASK(DIRECTION_WEST);
+	if (destination.y > current.y) directions |= DIRECTION_MASK(DIRECTION_SOUTH);
     } 
     else  // no negative direction to process, check if positive ones are needed
 	if (destination.x > current.x || destination.y < current.y) 
 	{
-	    if (destination.x > current.x) directions.push_back(DIRECTION_EAST);
-	    if (destination.y < current.y) directions.push_back(DIRECTION_NORTH);
+	    if (destination.x > current.x) directions |= DIRECTION_MASK(DIRECTION_EAST);
+	    if (destination.y < current.y) directions |= DIRECTION_MASK(DIRECTION_NORTH);
 	} 
 	else // both x and y were already reached
-	    directions.push_back(DIRECTION_LOCAL);
+	    directions |= DIRECTION_MASK(DIRECTION_LOCAL);
 
     return directions;
 }
@@ -9,7 +9,8 @@ using namespace std;
 
 class Routing_NORTH_LAST : RoutingAlgorithm {
 	public:
-		vector<int> route(Router * router, const RouteData & routeData);
+		unsigned int route(Router * router, const RouteData & routeData);
+		bool isTabulable() const { return true; }
 
 		static Routing_NORTH_LAST * getInstance();
 
@@ -19,7 +20,6 @@ class Routing_NORTH_LAST : RoutingAlgorithm {
 
 		static Routing_NORTH_LAST * routing_NORTH_LAST;
 		static RoutingAlgorithmsRegister routingAlgorithmsRegister;
-        static RoutingAlgorithm * xy;
 };
 
 #endif
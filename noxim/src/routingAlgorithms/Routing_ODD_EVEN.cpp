@@ -11,12 +11,18 @@ Routing_ODD_EVEN * Routing_ODD_EVEN::getInstance() {
 	return routing_ODD_EVEN;
 }
 
-vector<int> Routing_ODD_EVEN::route(Router * router, const RouteData & routeData)
+// The source only matters through whether it is in the current column
+int Routing_ODD_EVEN::sourceClass(const RouteData & routeData) const
+{
+    return id2Coord(routeData.src_id).x == id2Coord(routeData.current_id).x ? 1 : 0;
+}
+
+unsigned int Routing_ODD_EVEN::route(Router * router, const RouteData & routeData)
 {
     Coord current = id2Coord(routeData.current_id);
     Coord destination = id2Coord(routeData.dst_id);
     Coord source = id2Coord(routeData.src_id);
-    vector <int> directions;
+    unsigned int directions = 0;
 
     int c0 = current.x;
     int c1 = current.y;
@@ -30,35 +36,35 @@ vector<int> Routing_ODD_EVEN::route(Router * router, const RouteData & routeData
 
     if (e0 == 0) {
         if (e1 > 0)
-            directions.push_back(DIRECTION_NORTH);
+            directions |= DIRECTION_MASK(DIRECTION_NORTH);
         else
-            directions.push_back(DIRECTION_SOUTH);
+            directions |= DIRECTION_MASK(DIRECTION_SOUTH);
     } else {
         if (e0 > 0) {
             if (e1 == 0)
-                directions.push_back(DIRECTION_EAST);
+                directions |= DIRECTION_MASK(DIRECTION_EAST);
             else {
                 if ((c0 % 2 == 1) || (c0 == s0)) {
                     if (e1 > 0)
-                        directions.push_back(DIRECTION_NORTH);
+                        directions |= DIRECTION_MASK(DIRECTION_NORTH);
                     else
-                        directions.push_back(DIRECTION_SOUTH);
+                        directions |= DIRECTION_MASK(DIRECTION_SOUTH);
                 }
                 if ((d0 % 2 == 1) || (e0 != 1))
-                    directions.push_back(DIRECTION_EAST);
+                    directions |= DIRECTION_MASK(DIRECTION_EAST);
             }
         } else {
-            directions.push_back(DIRECTION_WEST);
+            directions |= DIRECTION_MASK(DIRECTION_WEST);
             if (c0 % 2 == 0) {
                 if (e1 > 0)
-                    directions.push_back(DIRECTION_NORTH);
+                    directions |= DIRECTION_MASK(DIRECTION_NORTH);
                 if (e1 < 0)
-                    directions.push_back(DIRECTION_SOUTH);
+                    directions |= DIRECTION_MASK(DIRECTION_SOUTH);
             }
         }
     }
 
-    assert(directions.size() > 0 && directions.size() <= 2);
+    assert(directions != 0 && __builtin_popcount(directions) <= 2);
 
     return directions;
 }
@@ -9,7 +9,10 @@ using namespace std;
 
 class Routing_ODD_EVEN : RoutingAlgorithm {
 	public:
-		vector<int> route(Router * router, const RouteData & routeData);
+		unsigned int route(Router * router, const RouteData & routeData);
+		bool isTabulable() const { return true; }
+		int sourceClasses() const { return 2; }
+		int sourceClass(const RouteData & routeData) const;
 
 		static Routing_ODD_EVEN * getInstance();
         inline string name() { return "Routing_ODD_EVEN";};
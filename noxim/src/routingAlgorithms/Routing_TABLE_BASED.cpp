@@ -11,21 +11,24 @@ Routing_TABLE_BASED * Routing_TABLE_BASED::getInstance() {
 	return routing_TABLE_BASED;
 }
 
-vector<int> Routing_TABLE_BASED::route(Router * router, const RouteData & routeData)
+unsigned int Routing_TABLE_BASED::route(Router * router, const RouteData & routeData)
 {
     Coord current = id2Coord(routeData.current_id);
     Coord destination = id2Coord(routeData.dst_id);
 
-    AdmissibleOutputs ao = router->routing_table.getAdmissibleOutputs(routeData.dir_in, routeData.dst_id);
+    // The table has a row per mesh input, hubs are not part of it
+    assert(routeData.dir_in >= 0 && routeData.dir_in <= DIRECTION_LOCAL);
 
-    if (ao.size() == 0) {
+    unsigned int ao = router->routing_table.getAdmissibleOutputs(routeData.dir_in, routeData.dst_id);
+
+    if (ao == 0) {
         LOG << "dir: " << routeData.dir_in << ", (" << current.x << "," << current.
             y << ") --> " << "(" << destination.x << "," << destination.
             y << ")" << endl << routeData.current_id << "->" <<
             routeData.dst_id << endl;
     }
 
-    assert(ao.size() > 0);
+    assert(ao != 0);
 
-    return admissibleOutputsSet2Vector(ao);
+    return ao;
 }
@@ -11,7 +11,7 @@ using namespace std;
 
 class Routing_TABLE_BASED : RoutingAlgorithm {
 	public:
-		vector<int> route(Router * router, const RouteData & routeData);
+		unsigned int route(Router * router, const RouteData & routeData);
 
 		static Routing_TABLE_BASED * getInstance();
 
@@ -9,7 +9,8 @@ using namespace std;
 
 class Routing_WEST_FIRST : RoutingAlgorithm {
 	public:
-		vector<int> route(Router * router, const RouteData & routeData);
+		unsigned int route(Router * router, const RouteData & routeData);
+		bool isTabulable() const { return true; }
 
 		static Routing_WEST_FIRST * getInstance();
 
@@ -19,7 +20,6 @@ class Routing_WEST_FIRST : RoutingAlgorithm {
 
 		static Routing_WEST_FIRST * routing_WEST_FIRST;
 		static RoutingAlgorithmsRegister routingAlgorithmsRegister;
-        static RoutingAlgorithm * xy;
 };
 
 #endif
@@ -11,20 +11,20 @@ Routing_XY * Routing_XY::getInstance() {
 	return routing_XY;
 }
 
-vector<int> Routing_XY::route(Router * router, const RouteData & routeData)
+unsigned int Routing_XY::route(Router * router, const RouteData & routeData)
 {
     Coord current = id2Coord(routeData.current_id);
     Coord destination = id2Coord(routeData.dst_id);
-    vector <int> directions;
+    unsigned int directions = 0;
 
     if (destination.x > current.x)
-        directions.push_back(DIRECTION_EAST);
+        directions |= DIRECTION_MASK(DIRECTION_EAST);
     else if (destination.x < current.x)
-        directions.push_back(DIRECTION_WEST);
+        directions |= DIRECTION_MASK(DIRECTION_WEST);
     else if (destination.y > current.y)
-        directions.push_back(DIRECTION_SOUTH);
+        directions |= DIRECTION_MASK(DIRECTION_SOUTH);
     else
-        directions.push_back(DIRECTION_NORTH);
+        directions |= DIRECTION_MASK(DIRECTION_NORTH);
 
     return directions;
 }
@@ -9,7 +9,8 @@ using namespace std;
 
 class Routing_XY : RoutingAlgorithm {
 	public:
-		vector<int> route(Router * router, const RouteData & routeData);
+		unsigned int route(Router * router, const RouteData & routeData);
+		bool isTabulable() const { return true; }
 
 		static Routing_XY * getInstance();
 
@@ -30,7 +30,7 @@ int Selection_NOP::apply(Router * router, const vector < int >&directions, const
 	tmp_route_data.dir_in = router->reflexDirection(directions[i]);
 
 
-	vector < int >next_candidate_channels =
+	unsigned int next_candidate_channels =
 	    router->routingFunction(tmp_route_data);
 
 	// select useful data from Neighbor-on-Path input 
@@ -59,7 +59,7 @@ int Selection_NOP::apply(Router * router, const vector < int >&directions, const
 	    equivalent_directions.push_back(directions[i]);
 
     direction_selected =
-	equivalent_directions[rand() % equivalent_directions.size()];
+	equivalent_directions[router->rng.below(equivalent_directions.size())];
 
     return direction_selected;
 }